@@ -0,0 +1,267 @@
+#include "Generators.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <set>
+#include <utility>
+
+namespace xor_smc {
+namespace bench {
+
+Instance random_ksat(uint32_t num_vars, uint32_t k, double ratio, uint64_t seed) {
+    assert(k <= num_vars);
+    Instance instance;
+    instance.name = "ksat" + std::to_string(k) + "_n" + std::to_string(num_vars) + "_r" +
+                    std::to_string(ratio).substr(0, 4) + "_s" + std::to_string(seed);
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<uint32_t> pick_var(0, num_vars - 1);
+    const size_t num_clauses = std::lround(ratio * num_vars);
+    Formula& formula = instance.formula;
+    formula.set_num_variables(num_vars);
+    formula.reserve(num_clauses, num_clauses * k);
+
+    std::vector<Literal> clause;
+    for (size_t i = 0; i < num_clauses; i++) {
+        clause.clear();
+        while (clause.size() < k) {
+            uint32_t var = pick_var(rng);
+            bool repeated = false;
+            for (const Literal& lit : clause) {
+                repeated |= lit.var_id() == var;
+            }
+            if (!repeated) {
+                clause.push_back(Literal(var, rng() & 1));
+            }
+        }
+        formula.add_clause(clause);
+    }
+    return instance;
+}
+
+Instance pigeonhole(uint32_t holes) {
+    Instance instance;
+    instance.name = "php" + std::to_string(holes);
+    instance.expected_sat = 0;
+
+    // Pigeon p in hole h
+    const uint32_t pigeons = holes + 1;
+    auto var = [holes](uint32_t p, uint32_t h) { return p * holes + h; };
+    Formula& formula = instance.formula;
+    formula.set_num_variables(pigeons * holes);
+
+    std::vector<Literal> clause;
+    for (uint32_t p = 0; p < pigeons; p++) {
+        clause.clear();
+        for (uint32_t h = 0; h < holes; h++) {
+            clause.push_back(Literal(var(p, h), true));
+        }
+        formula.add_clause(clause);
+    }
+    for (uint32_t h = 0; h < holes; h++) {
+        for (uint32_t p = 0; p < pigeons; p++) {
+            for (uint32_t q = p + 1; q < pigeons; q++) {
+                formula.add_clause({Literal(var(p, h), false), Literal(var(q, h), false)});
+            }
+        }
+    }
+    return instance;
+}
+
+Instance graph_coloring(uint32_t num_vertices, double average_degree, uint32_t colors, uint64_t seed) {
+    assert(num_vertices >= 2);
+    Instance instance;
+    instance.name = "color" + std::to_string(colors) + "_v" + std::to_string(num_vertices) + "_d" +
+                    std::to_string(average_degree).substr(0, 4) + "_s" + std::to_string(seed);
+
+    // Vertex v has colour c
+    auto var = [colors](uint32_t v, uint32_t c) { return v * colors + c; };
+    Formula& formula = instance.formula;
+    formula.set_num_variables(num_vertices * colors);
+
+    std::vector<Literal> clause;
+    for (uint32_t v = 0; v < num_vertices; v++) {
+        clause.clear();
+        for (uint32_t c = 0; c < colors; c++) {
+            clause.push_back(Literal(var(v, c), true));
+        }
+        formula.add_clause(clause);
+        for (uint32_t c = 0; c < colors; c++) {
+            for (uint32_t d = c + 1; d < colors; d++) {
+                formula.add_clause({Literal(var(v, c), false), Literal(var(v, d), false)});
+            }
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<uint32_t> pick_vertex(0, num_vertices - 1);
+    const uint64_t max_edges = uint64_t(num_vertices) * (num_vertices - 1) / 2;
+    const uint64_t num_edges = std::min<uint64_t>(std::lround(average_degree * num_vertices / 2), max_edges);
+    std::set<std::pair<uint32_t, uint32_t>> edges;
+    while (edges.size() < num_edges) {
+        uint32_t u = pick_vertex(rng);
+        uint32_t v = pick_vertex(rng);
+        if (u == v || !edges.emplace(std::min(u, v), std::max(u, v)).second) {
+            continue;
+        }
+        for (uint32_t c = 0; c < colors; c++) {
+            formula.add_clause({Literal(var(u, c), false), Literal(var(v, c), false)});
+        }
+    }
+    return instance;
+}
+
+Instance parity_chain(uint32_t length, uint32_t width, bool satisfiable, uint64_t seed) {
+    assert(width % 2 == 0 && width <= length);
+    Instance instance;
+    instance.name = "parity_n" + std::to_string(length) + "_w" + std::to_string(width) +
+                    (satisfiable ? "_sat" : "_unsat") + "_s" + std::to_string(seed);
+    instance.expected_sat = satisfiable;
+
+    std::mt19937_64 rng(seed);
+    std::vector<bool> planted(length);
+    for (uint32_t var = 0; var < length; var++) {
+        planted[var] = rng() & 1;
+    }
+
+    Formula& formula = instance.formula;
+    formula.set_num_variables(length);
+    std::vector<Literal> xor_lits;
+    for (uint32_t i = 0; i < length; i++) {
+        // XOR of the literals is true, so a negative one encodes parity 0
+        bool parity = false;
+        xor_lits.clear();
+        for (uint32_t j = 0; j < width; j++) {
+            uint32_t var = (i + j) % length;
+            parity ^= planted[var];
+            xor_lits.push_back(Literal(var, true));
+        }
+        if (!satisfiable && i == 0) {
+            parity = !parity;
+        }
+        if (!parity) {
+            xor_lits[0] = ~xor_lits[0];
+        }
+        formula.add_xor(xor_lits);
+    }
+    return instance;
+}
+
+Instance random_parity(uint32_t num_vars, uint32_t width, bool satisfiable, uint64_t seed) {
+    assert(width > 0 && 2 * num_vars % width == 0);
+    Instance instance;
+    instance.name = "xor_n" + std::to_string(num_vars) + "_w" + std::to_string(width) +
+                    (satisfiable ? "_sat" : "_unsat") + "_s" + std::to_string(seed);
+    instance.expected_sat = satisfiable;
+
+    std::mt19937_64 rng(seed);
+    std::vector<bool> planted(num_vars);
+    std::vector<uint32_t> occurrences;
+    for (uint32_t var = 0; var < num_vars; var++) {
+        planted[var] = rng() & 1;
+        occurrences.push_back(var);
+        occurrences.push_back(var);
+    }
+    std::shuffle(occurrences.begin(), occurrences.end(), rng);
+
+    Formula& formula = instance.formula;
+    formula.set_num_variables(num_vars);
+    std::vector<Literal> xor_lits;
+    for (size_t i = 0; i < occurrences.size(); i += width) {
+        // A variable twice in one XOR cancels out, on both sides
+        bool parity = false;
+        xor_lits.clear();
+        for (uint32_t j = 0; j < width; j++) {
+            uint32_t var = occurrences[i + j];
+            parity ^= planted[var];
+            xor_lits.push_back(Literal(var, true));
+        }
+        if (!satisfiable && i == 0) {
+            parity = !parity;
+        }
+        if (!parity) {
+            xor_lits[0] = ~xor_lits[0];
+        }
+        formula.add_xor(xor_lits);
+    }
+    return instance;
+}
+
+Instance counting_blocks(uint32_t num_blocks, uint32_t block_size, uint32_t padding_vars, uint64_t seed) {
+    assert(num_blocks > 0 && block_size > 0 && (padding_vars == 0 || padding_vars >= 3));
+    Instance instance;
+    instance.name = "blocks" + std::to_string(num_blocks) + "x" + std::to_string(block_size) + "_p" +
+                    std::to_string(padding_vars) + "_s" + std::to_string(seed);
+    instance.expected_sat = 1;
+    instance.model_count = std::pow(std::exp2(block_size) - 1, num_blocks);
+
+    // Block j has the counting variables j * block_size onwards, and the
+    // auxiliary num_blocks * block_size + j
+    const uint32_t first_aux = num_blocks * block_size;
+    Formula& formula = instance.formula;
+    const uint32_t first_padding = first_aux + num_blocks;
+    formula.set_num_variables(first_padding + padding_vars);
+
+    std::vector<Literal> clause;
+    for (uint32_t j = 0; j < num_blocks; j++) {
+        Literal aux(first_aux + j, true);
+        clause.assign({~aux});
+        for (uint32_t i = 0; i < block_size; i++) {
+            Literal x(j * block_size + i, true);
+            clause.push_back(x);
+            formula.add_clause({aux, ~x});
+            instance.counting_vars.push_back(x.var_id());
+        }
+        formula.add_clause(clause);
+    }
+
+    // Row j has auxiliary j and random later ones: triangular, so full rank
+    std::mt19937_64 rng(seed);
+    std::vector<Literal> xor_lits;
+    for (uint32_t j = 0; j < num_blocks; j++) {
+        xor_lits.assign({Literal(first_aux + j, true)});
+        for (uint32_t k = j + 1; k < num_blocks; k++) {
+            if (rng() & 1) {
+                xor_lits.push_back(Literal(first_aux + k, true));
+            }
+        }
+        // All true: parity of the row size
+        if (xor_lits.size() % 2 == 0) {
+            xor_lits[0] = ~xor_lits[0];
+        }
+        formula.add_xor(xor_lits);
+    }
+
+    // Random 3-clauses over the padding, kept only if a planted assignment
+    // satisfies them
+    std::vector<bool> planted(padding_vars);
+    for (uint32_t i = 0; i < padding_vars; i++) {
+        planted[i] = rng() & 1;
+    }
+    const size_t num_clauses = std::lround(3.5 * padding_vars);
+    for (size_t i = 0; i < num_clauses;) {
+        clause.clear();
+        bool satisfied = false;
+        while (clause.size() < 3) {
+            uint32_t var = rng() % padding_vars;
+            bool repeated = false;
+            for (const Literal& lit : clause) {
+                repeated |= lit.var_id() == first_padding + var;
+            }
+            if (!repeated) {
+                bool positive = rng() & 1;
+                satisfied |= planted[var] == positive;
+                clause.push_back(Literal(first_padding + var, positive));
+            }
+        }
+        if (satisfied) {
+            formula.add_clause(clause);
+            i++;
+        }
+    }
+    return instance;
+}
+
+}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "xor_smc/Formula.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xor_smc {
+namespace bench {
+
+// A generated problem, with what is known about it up front
+struct Instance {
+    std::string name;
+    Formula formula;
+    // Projection of counting instances; empty otherwise
+    std::vector<uint32_t> counting_vars;
+    // Known satisfiability: 1 SAT, 0 UNSAT, -1 unknown
+    int expected_sat = -1;
+    // Known number of models projected on counting_vars, or negative
+    double model_count = -1.0;
+};
+
+// Uniform random k-SAT with round(ratio * num_vars) clauses of k distinct
+// variables; 3-SAT is hardest near ratio 4.26
+Instance random_ksat(uint32_t num_vars, uint32_t k, double ratio, uint64_t seed);
+
+// holes + 1 pigeons in holes holes, always UNSAT
+Instance pigeonhole(uint32_t holes);
+
+// Proper colouring of a random graph with num_vertices vertices of the
+// given average degree, one variable per vertex and colour
+Instance graph_coloring(uint32_t num_vertices, double average_degree, uint32_t colors, uint64_t seed);
+
+// One XOR per window of width consecutive variables around a cycle of
+// length variables, with parities from a random planted assignment. With
+// satisfiable unset one parity is flipped: every variable is in an even
+// number of windows (width must be even), so the XORs then sum to 0 = 1.
+// The narrow band keeps it easy even for CNF search: it measures XOR
+// propagation along a long chain.
+Instance parity_chain(uint32_t length, uint32_t width, bool satisfiable, uint64_t seed);
+
+// Like parity_chain, but every variable is in two XORs picked at random
+// (Tseitin formulas on a random graph): exponentially hard for CNF search,
+// easy for Gauss-Jordan elimination. 2 * num_vars must be a multiple of
+// width.
+Instance random_parity(uint32_t num_vars, uint32_t width, bool satisfiable, uint64_t seed);
+
+// num_blocks blocks of block_size counting variables with at least one
+// true in each, through an auxiliary variable per block equivalent to the
+// block's disjunction. A full-rank system of random XORs over the
+// auxiliaries has all true as its only solution, so the projected count
+// is exactly (2^block_size - 1)^num_blocks. padding_vars more variables
+// under a planted, so satisfiable, random 3-SAT formula at ratio 3.5
+// leave the count
+// as it is but give each SMC trial some search to do.
+Instance counting_blocks(uint32_t num_blocks, uint32_t block_size, uint32_t padding_vars, uint64_t seed);
+
+}
+}
@@ -0,0 +1,306 @@
+#include "Generators.hpp"
+#include "xor_smc/Solver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace xor_smc;
+using namespace xor_smc::bench;
+
+namespace {
+
+struct Config {
+    bool quick = false;
+    int repeat = 3;
+    unsigned threads = 1;
+    std::string filter;
+    std::string out;
+};
+
+// One benchmark: the median of its repeats is what to track
+struct Result {
+    std::string kind;
+    std::string name;
+    std::string answer;
+    bool ok = true;  // The answer agrees with what is known of the instance
+    std::vector<double> seconds;
+    SolverStats stats;  // Of the last repeat
+};
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool satisfies(const Formula& formula, const std::vector<bool>& model) {
+    for (size_t i = 0; i < formula.num_clauses(); i++) {
+        bool sat = false;
+        for (const Literal& lit : formula.clause(i)) {
+            sat |= model[lit.var_id()] == lit.is_positive();
+        }
+        if (!sat) {
+            return false;
+        }
+    }
+    for (const XorConstraint& row : formula.xors()) {
+        bool parity = false;
+        for (uint32_t var : row.vars) {
+            parity ^= model[var];
+        }
+        if (parity != row.rhs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Result bench_solve(const Config& config, const Instance& instance, bool native_xor) {
+    Result result;
+    result.kind = "solve";
+    result.name = instance.name + (instance.formula.xors().empty() ? "" : native_xor ? "_native" : "_cnf");
+    for (int r = 0; r < config.repeat; r++) {
+        Solver solver;
+        solver.set_seed(1);
+        solver.set_native_xor(native_xor);
+        solver.add_formula(instance.formula);
+
+        auto start = std::chrono::steady_clock::now();
+        bool sat = solver.solve();
+        result.seconds.push_back(elapsed(start));
+        result.stats = solver.stats();
+        result.answer = sat ? "sat" : "unsat";
+        if (instance.expected_sat >= 0 && sat != bool(instance.expected_sat)) {
+            result.ok = false;
+        }
+        if (sat && !satisfies(instance.formula, solver.get_model())) {
+            result.ok = false;
+        }
+    }
+    return result;
+}
+
+// Incremental solves under many random assumptions on an easy formula:
+// almost all of the time goes to unit propagation
+Result bench_propagate(const Config& config, const Instance& instance, int rounds, uint32_t num_assumptions) {
+    Result result;
+    result.kind = "propagate";
+    result.name = instance.name + "_a" + std::to_string(num_assumptions);
+    const uint32_t num_vars = instance.formula.num_variables();
+    for (int r = 0; r < config.repeat; r++) {
+        Solver solver(instance.formula);
+        solver.set_seed(1);
+        solver.solve();
+        solver.reset_stats();
+
+        std::mt19937_64 rng(r);
+        std::uniform_int_distribution<uint32_t> pick_var(0, num_vars - 1);
+        std::vector<Literal> assumptions;
+        int num_sat = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            assumptions.clear();
+            for (uint32_t i = 0; i < num_assumptions; i++) {
+                assumptions.push_back(Literal(pick_var(rng), rng() & 1));
+            }
+            num_sat += solver.solve(assumptions);
+        }
+        result.seconds.push_back(elapsed(start));
+        result.stats = solver.stats();
+        result.answer = std::to_string(num_sat) + "/" + std::to_string(rounds) + " sat";
+    }
+    return result;
+}
+
+// solve_smc on one threshold, or solve_smc_sweep on all of them, of an
+// instance with a known count; a threshold well below the count should
+// pass and one well above fail
+Result bench_smc(const Config& config, const Instance& instance, const std::vector<uint32_t>& thresholds,
+                 bool sweep) {
+    Result result;
+    result.kind = sweep ? "smc_sweep" : "smc";
+    result.name = instance.name;
+    for (uint32_t threshold : thresholds) {
+        result.name += "_t" + std::to_string(threshold);
+    }
+
+    SmcOptions options;
+    options.num_threads = config.threads;
+    std::vector<std::vector<uint32_t>> counting(thresholds.size(), instance.counting_vars);
+    std::vector<std::vector<uint32_t>> fixed(thresholds.size());
+    for (int r = 0; r < config.repeat; r++) {
+        Solver solver(instance.formula);
+        solver.set_seed(1 + r);
+
+        std::vector<bool> verdicts;
+        auto start = std::chrono::steady_clock::now();
+        if (sweep) {
+            verdicts = solver.solve_smc_sweep(thresholds, counting, options);
+        } else {
+            verdicts.push_back(solver.solve_smc(thresholds, counting, fixed, options));
+        }
+        result.seconds.push_back(elapsed(start));
+        result.stats = solver.smc_stats().solver;
+
+        result.answer.clear();
+        for (size_t i = 0; i < verdicts.size(); i++) {
+            result.answer += verdicts[i] ? "pass" : "fail";
+            result.answer += i + 1 < verdicts.size() ? "," : "";
+            if (!sweep) {
+                // One verdict for all thresholds
+                bool expected = true;
+                for (uint32_t threshold : thresholds) {
+                    expected &= threshold <= instance.model_count / 4;
+                }
+                result.ok &= verdicts[i] == expected;
+            } else if (thresholds[i] <= instance.model_count / 4 || thresholds[i] >= instance.model_count * 4) {
+                result.ok &= verdicts[i] == (thresholds[i] < instance.model_count);
+            }
+        }
+    }
+    return result;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+void write_json(std::ostream& out, const Config& config, const std::vector<Result>& results) {
+    out << "{\n";
+    out << "  \"version\": \"" << XOR_SMC_VERSION << "\",\n";
+#ifdef XOR_SMC_NO_STATS
+    out << "  \"stats\": false,\n";
+#else
+    out << "  \"stats\": true,\n";
+#endif
+    out << "  \"quick\": " << (config.quick ? "true" : "false") << ",\n";
+    out << "  \"repeat\": " << config.repeat << ",\n";
+    out << "  \"threads\": " << config.threads << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        double seconds = median(r.seconds);
+        const SolverStats& s = r.stats;
+        out << "    {\"kind\": \"" << r.kind << "\", \"name\": \"" << r.name << "\", \"answer\": \"" << r.answer
+            << "\", \"ok\": " << (r.ok ? "true" : "false")
+            << ", \"seconds\": " << seconds
+            << ", \"min_seconds\": " << *std::min_element(r.seconds.begin(), r.seconds.end())
+            << ", \"decisions\": " << s.decisions << ", \"conflicts\": " << s.conflicts
+            << ", \"propagations\": " << s.propagations
+            << ", \"propagations_per_second\": " << (seconds > 0 ? s.propagations / seconds : 0)
+            << ", \"watch_visits\": " << s.watch_visits
+            << ", \"xor_row_additions\": " << s.xor_stats.row_additions
+            << ", \"peak_clause_bytes\": " << s.peak_clause_bytes << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+void usage(const char* program) {
+    std::cerr << "usage: " << program << " [--quick] [--repeat N] [--threads N] [--filter TEXT] [--out FILE]\n"
+              << "Runs the solver benchmarks and writes the results as JSON, to stdout by default.\n"
+              << "--filter keeps the benchmarks whose label (kind and family, e.g. \"solve php\") contains TEXT.\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--quick")) {
+            config.quick = true;
+        } else if (!std::strcmp(argv[i], "--repeat") && has_value) {
+            config.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--threads") && has_value) {
+            config.threads = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--filter") && has_value) {
+            config.filter = argv[++i];
+        } else if (!std::strcmp(argv[i], "--out") && has_value) {
+            config.out = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    const bool quick = config.quick;
+
+    // Each benchmark builds its instance only if it is selected
+    std::vector<std::pair<std::string, std::function<Result()>>> benchmarks;
+    auto add = [&](const std::string& label, std::function<Result()> run) {
+        benchmarks.emplace_back(label, std::move(run));
+    };
+
+    for (uint64_t seed = 1; seed <= 4; seed++) {
+        add("solve ksat3", [&, seed] {
+            return bench_solve(config, random_ksat(quick ? 150 : 230, 3, 4.26, seed), true);
+        });
+    }
+    add("solve php", [&] { return bench_solve(config, pigeonhole(quick ? 7 : 8), true); });
+    for (uint64_t seed = 1; seed <= 2; seed++) {
+        add("solve color", [&, seed] {
+            return bench_solve(config, graph_coloring(quick ? 200 : 400, 4.4, 3, seed), true);
+        });
+    }
+    for (bool satisfiable : {true, false}) {
+        add("solve parity", [&, satisfiable] {
+            return bench_solve(config, parity_chain(quick ? 1000 : 10000, 4, satisfiable, 1), true);
+        });
+        add("solve parity", [&, satisfiable] {
+            return bench_solve(config, parity_chain(quick ? 1000 : 10000, 4, satisfiable, 1), false);
+        });
+        // The CNF expansion is exponentially harder than elimination
+        add("solve xor", [&, satisfiable] {
+            return bench_solve(config, random_parity(quick ? 1500 : 6000, 3, satisfiable, 1), true);
+        });
+        add("solve xor", [&, satisfiable] {
+            return bench_solve(config, random_parity(quick ? 60 : 90, 3, satisfiable, 1), false);
+        });
+    }
+    add("solve blocks", [&] { return bench_solve(config, counting_blocks(6, 4, quick ? 1000 : 4000, 1), true); });
+
+    add("propagate ksat3", [&] {
+        return bench_propagate(config, random_ksat(quick ? 20000 : 100000, 3, 3.0, 1), 20, 100);
+    });
+
+    // 15^6 is about 2^23.4
+    const uint32_t padding = quick ? 1000 : 4000;
+    add("smc blocks", [&] { return bench_smc(config, counting_blocks(6, 4, padding, 1), {1u << 20}, false); });
+    add("smc blocks", [&] { return bench_smc(config, counting_blocks(6, 4, padding, 1), {1u << 27}, false); });
+    add("smc_sweep blocks", [&] {
+        return bench_smc(config, counting_blocks(6, 4, padding, 1), {1u << 16, 1u << 20, 1u << 27, 1u << 30}, true);
+    });
+
+    std::vector<Result> results;
+    bool all_ok = true;
+    for (auto& [label, run] : benchmarks) {
+        if (!config.filter.empty() && label.find(config.filter) == std::string::npos) {
+            continue;
+        }
+        Result result = run();
+        std::cerr << result.kind << " " << result.name << ": " << result.answer << " in " << median(result.seconds)
+                  << " s" << (result.ok ? "" : "  WRONG") << "\n";
+        all_ok &= result.ok;
+        results.push_back(std::move(result));
+    }
+
+    if (config.out.empty()) {
+        write_json(std::cout, config, results);
+    } else {
+        std::ofstream out(config.out);
+        write_json(out, config, results);
+        if (!out) {
+            std::cerr << config.out << ": cannot write\n";
+            return 1;
+        }
+    }
+    return all_ok ? 0 : 1;
+}
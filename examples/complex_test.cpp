@@ -1,5 +1,6 @@
 #include "xor_smc/Solver.hpp"
 #include <iostream>
+#include <cassert>
 #include <vector>
 
 using namespace xor_smc;
@@ -0,0 +1,43 @@
+#include "xor_smc/Solver.hpp"
+#include "xor_smc/Dimacs.hpp"
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+using namespace xor_smc;
+
+// Solves a DIMACS CNF file, with optional XOR lines, and prints the
+// answer in the SAT competition format
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <file.cnf>\n";
+        return 1;
+    }
+
+    Formula formula;
+    DimacsInfo info;
+    auto start = std::chrono::steady_clock::now();
+    if (!load_dimacs(argv[1], formula, info)) {
+        std::cerr << argv[1] << ": " << info.error << "\n";
+        return 1;
+    }
+    Solver solver(std::move(formula));
+    std::chrono::duration<double> parse_time = std::chrono::steady_clock::now() - start;
+    std::cout << "c parsed " << info.clauses_read << " clauses and " << info.xors_read
+              << " XORs over " << solver.num_variables() << " variables in "
+              << parse_time.count() << " s\n";
+    if (!info.projection.empty()) {
+        std::cout << "c projection on " << info.projection.size() << " variables\n";
+    }
+
+    if (!solver.solve()) {
+        std::cout << "s UNSATISFIABLE\n";
+        return 20;
+    }
+    std::cout << "s SATISFIABLE\nv";
+    for (uint32_t var = 0; var < solver.num_variables(); var++) {
+        std::cout << " " << (solver.get_value(var) ? "" : "-") << var + 1;
+    }
+    std::cout << " 0\n";
+    return 10;
+}
@@ -1,4 +1,5 @@
 #include "xor_smc/Solver.hpp"
+#include "xor_smc/Log.hpp"
 #include <iostream>
 #include <vector>
 
@@ -24,7 +25,28 @@ void test_counting() {
               << (result ? ">=" : "<") << " 16 solutions\n";
 }
 
+void test_approx_count() {
+    // x0..x9 free, x10..x19 copies of them: 2^10 solutions over x0..x19
+    Solver solver;
+    solver.set_num_variables(20);
+    for (uint32_t i = 0; i < 10; i++) {
+        solver.add_clause({Literal(i, true), Literal(i + 10, false)});
+        solver.add_clause({Literal(i, false), Literal(i + 10, true)});
+    }
+
+    std::vector<uint32_t> counting_vars;
+    for (uint32_t i = 0; i < 20; i++) {
+        counting_vars.push_back(i);
+    }
+
+    CountResult count = solver.count(counting_vars);
+    std::cout << "\nApproximate count: " << count.estimate() << " (exact: 1024)\n";
+}
+
 int main() {
+    // Show the progress of each vote and count
+    set_log_level(LogLevel::Info);
     test_counting();
+    test_approx_count();
     return 0;
 }
\ No newline at end of file
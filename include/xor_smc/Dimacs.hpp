@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xor_smc {
+
+class Solver;
+class Formula;
+
+struct DimacsInfo {
+    // As declared by the "p cnf" header; the solver grows past them if a
+    // literal needs it
+    uint32_t num_variables = 0;
+    uint64_t num_clauses = 0;
+
+    uint64_t clauses_read = 0;
+    uint64_t xors_read = 0;
+    // Variables of the "c ind" and "c p show" lines, sorted, empty if the
+    // file has none
+    std::vector<uint32_t> projection;
+
+    // Why loading stopped, with the line number, when it failed
+    std::string error;
+};
+
+// Loads a DIMACS CNF file into the solver. Besides clauses it reads
+// "x" lines as XORs ("x1 -2 3 0" is x1 ⊕ ¬x2 ⊕ x3 = 1) and the
+// projection lines of ApproxMC ("c ind") and of the model counting
+// competition ("c p show"). The file is mapped rather than read, and
+// clauses go to the solver through one reused buffer.
+bool load_dimacs(const std::string& path, Solver& solver, DimacsInfo& info);
+// Into a formula, which a solver can then adopt without copying the
+// clauses and with every watch list sized in advance
+bool load_dimacs(const std::string& path, Formula& formula, DimacsInfo& info);
+
+// Same, from a buffer that need not be null-terminated
+bool parse_dimacs(const char* data, size_t size, Solver& solver, DimacsInfo& info);
+bool parse_dimacs(const char* data, size_t size, Formula& formula, DimacsInfo& info);
+
+}
@@ -1,40 +1,67 @@
 #pragma once
 #include "Literal.hpp"
+#include "XorEngine.hpp"
 #include <vector>
+#include <initializer_list>
+#include <cstddef>
+#include <cstdint>
 
 namespace xor_smc {
 
-class Clause {
+// A CNF formula with XORs, independent of any solver. Clauses of three or
+// more literals are kept back to back in one array in the layout of the
+// solver's clause arena (a size word, a flags word, then the literals),
+// indexed by an offset array, so a solver can adopt a moved-in formula's
+// clauses without copying them. Units and binaries, which the solver keeps
+// outside its arena, are stored apart. Solvers never share clause memory,
+// since watching reorders literals in place: each one starting from the
+// same formula takes its own copy.
+class Formula {
 public:
-    explicit Clause(const std::vector<Literal>& literals) 
-        : literals_(literals) {}
-    
-    const std::vector<Literal>& literals() const { return literals_; }
+    // Literals are sorted by variable and repeats dropped; tautologies are
+    // not stored and an empty clause only sets has_empty_clause()
+    void add_clause(const std::vector<Literal>& literals);
+    void add_clause(std::initializer_list<Literal> literals);
+    void add_clause(const Literal* literals, size_t size);
+    // XOR of xor_lits is true
+    void add_xor(const std::vector<Literal>& xor_lits);
 
-private:
-    std::vector<Literal> literals_;
-};
+    // Declares variables that may not occur in any clause
+    void set_num_variables(uint32_t num_vars);
+    void reserve(size_t num_clauses, size_t num_literals);
 
-class Formula {
-public:
-    void add_clause(const std::vector<Literal>& literals) {
-        clauses_.emplace_back(literals);
-    }
-    
-    const std::vector<Clause>& clauses() const { return clauses_; }
-    
-    size_t num_variables() const {
-        size_t max_var = 0;
-        for (const auto& clause : clauses_) {
-            for (const auto& lit : clause.literals()) {
-                max_var = std::max(max_var, static_cast<size_t>(lit.var_id()));
-            }
+    // Units first, then binaries, then the longer clauses
+    size_t num_clauses() const { return units_.size() + binaries_.size() / 2 + offsets_.size(); }
+    LiteralSpan clause(size_t i) const {
+        if (i < units_.size()) {
+            return {&units_[i], 1};
+        }
+        i -= units_.size();
+        if (i < binaries_.size() / 2) {
+            return {&binaries_[2 * i], 2};
         }
-        return max_var + 1;
+        const uint32_t* header = words_.data() + offsets_[i - binaries_.size() / 2];
+        return {reinterpret_cast<const Literal*>(header + kHeaderWords), header[0]};
     }
+    const std::vector<XorConstraint>& xors() const { return xors_; }
+    bool has_empty_clause() const { return has_empty_clause_; }
+
+    // One past the largest variable seen, or as declared
+    uint32_t num_variables() const { return num_vars_; }
 
 private:
-    std::vector<Clause> clauses_;
+    friend class Solver;
+    friend class Preprocessor;
+    static constexpr uint32_t kHeaderWords = 2;
+
+    std::vector<Literal> units_;
+    std::vector<Literal> binaries_;  // Two literals each
+    std::vector<uint32_t> words_;
+    std::vector<uint32_t> offsets_;  // Start of each clause's header in words_
+    std::vector<XorConstraint> xors_;
+    std::vector<Literal> buffer_;  // Normalizes clauses before they are stored
+    uint32_t num_vars_ = 0;
+    bool has_empty_clause_ = false;
 };
 
 }
@@ -0,0 +1,43 @@
+#pragma once
+#include "XorEngine.hpp"
+#include <vector>
+#include <cstdint>
+#include <random>
+
+namespace xor_smc {
+
+// Random XOR hash families h(x) = Ax + b over GF(2). Every family draws b
+// uniformly, so each assignment satisfies a row with probability exactly
+// 1/2 and the expected number of surviving solutions is always count/2^m:
+// "fewer solutions than the threshold, so the trial is probably UNSAT"
+// holds for all of them. They differ in how correlated two solutions are,
+// which governs "more solutions than the threshold, so probably SAT".
+enum class HashFamily {
+    // Every variable in every row with probability 1/2. Pairwise
+    // independent; rows have about n/2 variables.
+    Dense,
+    // Every variable in every row with probability density (see
+    // sparse_density). Two solutions at Hamming distance w collide with
+    // probability ((1 + (1 - 2 density)^w) / 2)^m rather than 2^-m, so
+    // solutions that are close together weaken the SAT direction. Rows
+    // have about density * n variables, which is far cheaper to
+    // propagate and eliminate.
+    Sparse,
+    // A is a random Toeplitz matrix, A[i][j] = t[i - j + n - 1], drawn from
+    // n + m - 1 bits. Pairwise independent like Dense, with the same row
+    // length, and the first k rows of an m-row hash form a k-row hash.
+    Toeplitz,
+};
+
+// Seed mixer for deriving independent random streams from one seed
+uint64_t splitmix64(uint64_t x);
+
+// Expected variables per sparse row of about 2 log2(n), stretched as m
+// approaches n, where short rows start to overlap
+double sparse_density(uint32_t num_vars, uint32_t num_rows);
+
+// Draws an m-row hash over vars. A negative density picks sparse_density().
+std::vector<XorConstraint> draw_hash(HashFamily family, const std::vector<uint32_t>& vars,
+                                     uint32_t num_rows, double density, std::mt19937_64& rng);
+
+}
@@ -5,14 +5,29 @@ namespace xor_smc {
 
 class Literal {
 public:
+    Literal() : data_(0) {}
     Literal(uint32_t var, bool positive) 
         : data_((var << 1) | static_cast<uint32_t>(positive)) {}
     
     uint32_t var_id() const { return data_ >> 1; }
     bool is_positive() const { return data_ & 1; }
+
+    Literal operator~() const { return Literal(var_id(), !is_positive()); }
+    bool operator==(const Literal& other) const { return data_ == other.data_; }
+    bool operator!=(const Literal& other) const { return data_ != other.data_; }
     
 private:
     uint32_t data_;  
 };
 
-}
\ No newline at end of file
+// Read-only view of a run of literals stored elsewhere
+struct LiteralSpan {
+    const Literal* first;
+    uint32_t count;
+    const Literal* begin() const { return first; }
+    const Literal* end() const { return first + count; }
+    uint32_t size() const { return count; }
+    const Literal& operator[](uint32_t i) const { return first[i]; }
+};
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace xor_smc {
+
+enum class LogLevel : int {
+    Off = 0,
+    Error = 1,
+    Warning = 2,
+    Info = 3,
+    Debug = 4,
+    Trace = 5,
+};
+
+// Receives every message at or below the current level, one call per
+// message, never concurrently
+using LogSink = std::function<void(LogLevel level, const std::string& message)>;
+
+// Nothing is logged by default
+void set_log_level(LogLevel level);
+LogLevel log_level();
+// Replaces the sink, which writes to std::cerr by default; nullptr
+// restores it
+void set_log_sink(LogSink sink);
+
+bool log_enabled(LogLevel level);
+void log_message(LogLevel level, const std::string& message);
+
+}
+
+// Levels above XOR_SMC_LOG_MAX_LEVEL are compiled out with their
+// arguments. Release builds (NDEBUG) keep up to Info, others everything.
+#ifndef XOR_SMC_LOG_MAX_LEVEL
+#ifdef NDEBUG
+#define XOR_SMC_LOG_MAX_LEVEL 3
+#else
+#define XOR_SMC_LOG_MAX_LEVEL 5
+#endif
+#endif
+
+// XOR_SMC_LOG(Info, "x = " << x): the stream expression is only evaluated
+// when the level is enabled
+#define XOR_SMC_LOG(level, expr)                                                    \
+    do {                                                                            \
+        if (::xor_smc::log_enabled(::xor_smc::LogLevel::level)) {                   \
+            std::ostringstream xor_smc_log_stream_;                                 \
+            xor_smc_log_stream_ << expr;                                            \
+            ::xor_smc::log_message(::xor_smc::LogLevel::level, xor_smc_log_stream_.str()); \
+        }                                                                           \
+    } while (0)
+
+#define XOR_SMC_LOG_DISABLED() do {} while (0)
+
+#if XOR_SMC_LOG_MAX_LEVEL >= 1
+#define XOR_SMC_ERROR(expr) XOR_SMC_LOG(Error, expr)
+#else
+#define XOR_SMC_ERROR(expr) XOR_SMC_LOG_DISABLED()
+#endif
+
+#if XOR_SMC_LOG_MAX_LEVEL >= 2
+#define XOR_SMC_WARNING(expr) XOR_SMC_LOG(Warning, expr)
+#else
+#define XOR_SMC_WARNING(expr) XOR_SMC_LOG_DISABLED()
+#endif
+
+#if XOR_SMC_LOG_MAX_LEVEL >= 3
+#define XOR_SMC_INFO(expr) XOR_SMC_LOG(Info, expr)
+#else
+#define XOR_SMC_INFO(expr) XOR_SMC_LOG_DISABLED()
+#endif
+
+#if XOR_SMC_LOG_MAX_LEVEL >= 4
+#define XOR_SMC_DEBUG(expr) XOR_SMC_LOG(Debug, expr)
+#else
+#define XOR_SMC_DEBUG(expr) XOR_SMC_LOG_DISABLED()
+#endif
+
+#if XOR_SMC_LOG_MAX_LEVEL >= 5
+#define XOR_SMC_TRACE(expr) XOR_SMC_LOG(Trace, expr)
+#else
+#define XOR_SMC_TRACE(expr) XOR_SMC_LOG_DISABLED()
+#endif
@@ -0,0 +1,150 @@
+#pragma once
+#include "Literal.hpp"
+#include "Formula.hpp"
+#include "Stats.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xor_smc {
+
+struct PreprocessOptions {
+    bool substitute = true;  // Equivalent literals replaced by one of them
+    bool subsume = true;    // Subsumption and self-subsuming strengthening
+    bool probe = true;      // Failed literals and literals implied both ways
+    bool eliminate = true;  // Bounded variable elimination
+
+    // A variable is eliminated only if it has at most max_occurrences
+    // clauses on one side, no resolvent is longer than max_resolvent_size
+    // and the resolvents outnumber the clauses they replace by at most
+    // max_growth
+    uint32_t max_occurrences = 16;
+    uint32_t max_resolvent_size = 20;
+    int max_growth = 0;
+
+    // Literal visits each technique may spend
+    uint64_t max_steps = 20000000;
+};
+
+// Simplifies the CNF part of a formula before search. Simplification keeps
+// the set of models projected onto the variables that are not eliminated:
+// units, subsumption and strengthening keep the formula equivalent, and
+// eliminating x by resolution replaces the clauses on x with the ones
+// that say "some value of x works". Literals equivalent through a cycle of
+// binary clauses, or through an XOR of two variables, are replaced by one
+// representative in every clause and XOR. A model of the simplified
+// formula is turned into a model of the original by extend_model(), which
+// replays the removed clauses from the last elimination back.
+//
+// Frozen variables are never eliminated or substituted: a frozen variable
+// equivalent to another keeps the two binary clauses that say so. XOR
+// variables may be substituted but not eliminated, and XORs take no part
+// in probing; XORs of one or two variables become units and clauses.
+class Preprocessor {
+public:
+    // Replaces formula by its simplification; false if it was found UNSAT,
+    // with formula then holding the empty clause. Several runs add up:
+    // extend_model() undoes all of them.
+    bool run(Formula& formula, const std::vector<uint32_t>& frozen, const PreprocessOptions& options = {});
+
+    // Sets the eliminated and substituted variables of a model of the
+    // simplified formula so that it satisfies the original one
+    void extend_model(std::vector<bool>& model) const;
+    // Eliminated or substituted: the variable is gone from the formula
+    bool is_eliminated(uint32_t var) const { return var < eliminated_.size() && eliminated_[var]; }
+
+    // Summed over the runs
+    const PreprocessStats& stats() const { return stats_; }
+
+private:
+    struct ClauseInfo {
+        uint32_t start;  // First literal in literals_
+        uint32_t size;
+        uint64_t signature;  // One bit per variable modulo 64
+        bool removed;
+    };
+
+    static uint32_t index(const Literal& lit) { return lit.var_id() * 2 + !lit.is_positive(); }
+    static Literal literal(uint32_t index) { return Literal(index >> 1, !(index & 1)); }
+    static uint64_t signature(const Literal* lits, uint32_t size);
+    Literal* begin(uint32_t c) { return literals_.data() + clauses_[c].start; }
+    Literal* end(uint32_t c) { return begin(c) + clauses_[c].size; }
+    int value(const Literal& lit) const {
+        int v = values_[lit.var_id()];
+        return lit.is_positive() ? v : -v;
+    }
+
+    void load(const Formula& formula, const std::vector<uint32_t>& frozen);
+    // Sorts, cancels repeated variables and folds assigned ones into the
+    // right-hand side; XORs of fewer than three variables become units
+    // and clauses
+    void add_xor(XorConstraint constraint);
+    void mark_xor_variables();
+    Formula unload(const Formula& formula) const;
+    uint32_t add_clause(const Literal* lits, uint32_t size);
+    void remove_clause(uint32_t c);
+    // Drops lit from clause c, turning it into a unit if one literal is left
+    void strengthen(uint32_t c, const Literal& lit);
+    // Live clauses containing lit
+    const std::vector<uint32_t>& occurrences(const Literal& lit);
+
+    // Top-level unit propagation over the occurrence lists: satisfied
+    // clauses go, false literals are cut out of the rest
+    void enqueue_unit(const Literal& lit);
+    bool propagate_units();
+
+    void subsume_all();
+    bool run_subsumption();
+    void backward_subsume(uint32_t c);
+    bool subsumed_by_existing(const std::vector<Literal>& lits, uint64_t sig);
+
+    // Rounds of substitution until no variable is left to replace
+    bool substitute_all();
+    // Replaces each variable by the representative of its strongly
+    // connected component in the binary implication graph; false if
+    // nothing was replaced
+    bool substitute_equivalences();
+    // Maps the members of one component, given by literal index, to the
+    // representative; false if it holds a literal and its negation
+    bool choose_representative(const std::vector<uint32_t>& component, std::vector<Literal>& replacement,
+                               std::vector<uint8_t>& mapped);
+
+    bool probe_all();
+    // Assigns lit on a probe level and propagates; false on a conflict
+    bool probe_propagate(const Literal& lit);
+    void undo_probe();
+
+    bool eliminate_all();
+    bool try_eliminate(uint32_t var);
+    // The resolvent of p and n on their clashing variable, or false if it
+    // is a tautology
+    bool resolve(uint32_t p, uint32_t n, uint32_t var, std::vector<Literal>& resolvent);
+    void push_extension(uint32_t c, const Literal& pivot);
+
+    PreprocessOptions options_;
+    PreprocessStats stats_;
+    bool ok_ = true;
+    uint64_t steps_ = 0;
+
+    std::vector<Literal> literals_;
+    std::vector<ClauseInfo> clauses_;
+    std::vector<std::vector<uint32_t>> occurs_;  // Clauses of each literal, by index()
+    std::vector<int8_t> values_;  // 1 true, -1 false, 0 unassigned
+    std::vector<Literal> units_;  // Top-level trail
+    size_t units_head_ = 0;
+    std::vector<XorConstraint> xors_;
+    std::vector<uint8_t> frozen_;
+    std::vector<uint8_t> in_xor_;
+    std::vector<uint8_t> marks_;  // Per literal index, scratch
+    std::vector<uint32_t> subsume_queue_;
+    std::vector<uint8_t> touched_;  // Variables whose clauses changed since the last elimination round
+    std::vector<Literal> probe_trail_;
+
+    // Removed clauses of eliminated variables, and the equivalence of each
+    // substituted one, the pivot first; extension_sizes_ holds their sizes
+    std::vector<Literal> extension_;
+    std::vector<uint32_t> extension_sizes_;
+    std::vector<uint8_t> eliminated_;
+};
+
+}
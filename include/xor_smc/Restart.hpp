@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace xor_smc {
+
+// Decides when the search should abandon its current decisions and
+// backtrack to level 0. Learnt clauses and activities are kept.
+class RestartPolicy {
+public:
+    virtual ~RestartPolicy() = default;
+
+    // Called once per conflict with the LBD of the learnt clause and the
+    // number of assigned variables at the time of the conflict.
+    virtual void on_conflict(uint32_t lbd, size_t trail_size) = 0;
+    virtual bool should_restart() const = 0;
+    virtual void on_restart() = 0;
+};
+
+// Restarts after unit * luby(i) conflicts, where luby is the sequence
+// 1 1 2 1 1 2 4 1 1 2 ...
+class LubyRestart : public RestartPolicy {
+public:
+    explicit LubyRestart(uint64_t unit = 100);
+
+    void on_conflict(uint32_t lbd, size_t trail_size) override;
+    bool should_restart() const override;
+    void on_restart() override;
+
+    static double luby(double y, uint64_t x);
+
+private:
+    uint64_t unit_;
+    uint64_t restarts_;
+    uint64_t conflicts_;
+    uint64_t limit_;
+};
+
+// Glucose-style dynamic restarts with exponential moving averages: restart
+// when recent learnt clauses are markedly worse (higher LBD) than the long
+// term average, and block a restart when the trail is much larger than
+// usual, which suggests the solver is close to a model.
+class GlucoseRestart : public RestartPolicy {
+public:
+    GlucoseRestart(double margin = 1.25, double block_margin = 1.4,
+                   uint64_t min_conflicts = 50, uint64_t block_after = 10000);
+
+    void on_conflict(uint32_t lbd, size_t trail_size) override;
+    bool should_restart() const override;
+    void on_restart() override;
+
+private:
+    // Bias-corrected exponential moving average
+    class Ema {
+    public:
+        explicit Ema(double alpha) : alpha_(alpha), value_(0), weight_(0) {}
+        void update(double x) {
+            value_ += alpha_ * (x - value_);
+            weight_ += alpha_ * (1 - weight_);
+        }
+        double value() const { return weight_ > 0 ? value_ / weight_ : 0; }
+
+    private:
+        double alpha_;
+        double value_;
+        double weight_;
+    };
+
+    double margin_;
+    double block_margin_;
+    uint64_t min_conflicts_;
+    uint64_t block_after_;
+
+    Ema fast_lbd_;
+    Ema slow_lbd_;
+    Ema trail_;
+    uint64_t conflicts_;
+    uint64_t conflicts_since_restart_;
+};
+
+}
@@ -1,26 +1,163 @@
 #pragma once
 #include "Literal.hpp"
+#include "Formula.hpp"
+#include "XorEngine.hpp"
+#include "VarHeap.hpp"
+#include "Restart.hpp"
+#include "Hash.hpp"
+#include "Stats.hpp"
+#include "Preprocessor.hpp"
 #include <vector>
 #include <memory>
-#include <array>
-#include <random>
+#include <atomic>
+#include <initializer_list>
 
 namespace xor_smc {
 
+struct SmcOptions {
+    // Worker threads running trials: 1 runs them in order on the calling
+    // thread, 0 uses every hardware thread
+    unsigned num_threads = 1;
+
+    // Each threshold is decided by a majority vote over at most
+    // max(num_xor_tries, ln(1/(1 - confidence)) / (2 bias^2)) trials (the
+    // Hoeffding bound), where bias is the assumed distance of a trial's
+    // SAT probability from 1/2. A sequential probability ratio test stops
+    // the vote as soon as the outcome is settled at the same confidence,
+    // or earlier if the remaining trials cannot change the majority.
+    // A confidence outside (0.5, 1) drops the Hoeffding bound and the
+    // sequential test: the vote runs num_xor_tries trials, rounded up to an
+    // odd count, and still stops once the majority is out of reach.
+    int num_xor_tries = 10;
+    double confidence = 0.99;
+    double bias = 0.25;
+
+    // Family of the random XOR hashes; see HashFamily for the guarantees
+    // each one keeps. A negative sparse_density picks it from the counting
+    // set size and the number of XORs.
+    HashFamily hash = HashFamily::Dense;
+    double sparse_density = -1.0;
+
+    // Simplify the base formula the trials share once, up front, keeping
+    // every counting and fixed variable
+    bool preprocess = true;
+};
+
+// Trials the vote on one threshold may run
+int smc_trial_budget(const SmcOptions& options);
+// Lead of SAT over UNSAT trials, or the reverse, that ends a vote early;
+// INT_MAX when the sequential test is off
+int smc_vote_margin(const SmcOptions& options);
+
+struct CountOptions {
+    // The estimate is within a factor 1 + epsilon of the projected count
+    // with probability at least 1 - delta
+    double epsilon = 0.8;
+    double delta = 0.2;
+    // Each repetition draws one hash with a row per counting variable and
+    // tests prefixes of it. A negative sparse_density picks the density
+    // of the full hash, which sparse_density() never makes lower than
+    // that of a shorter prefix: every prefix tested is at least as dense,
+    // so at least as close to pairwise independent, as a hash drawn for
+    // its own length.
+    HashFamily hash = HashFamily::Dense;
+    double sparse_density = -1.0;
+    // Simplify the copy of the problem, keeping the counting variables
+    bool preprocess = true;
+};
+
+// A projected model count of cell_count * 2^num_hashes: the solutions
+// counted in one cell of a hash with num_hashes XORs, or an exact count
+// when num_hashes is 0 and exact is set
+struct CountResult {
+    uint64_t cell_count;
+    uint32_t num_hashes;
+    bool exact;
+
+    double estimate() const;
+};
+
 class Solver {
 public:
     Solver();
+    // Starts from a formula. A moved-in formula's clause array becomes the
+    // solver's clause storage as is; a copied one is copied in one block,
+    // so many solvers can start from one base formula, each with its own
+    // copy of it.
+    explicit Solver(Formula formula);
 
     void set_num_variables(uint32_t num_vars);
+    // Adds one variable and returns its index
+    uint32_t new_var();
+
     bool solve();
+    // Solves with the assumption literals forced true for this call only.
+    // Learnt clauses are kept between calls. After an UNSAT answer,
+    // failed_assumptions() is a subset of the assumptions that is already
+    // inconsistent with the formula; it is empty if the formula, together
+    // with the active groups, is UNSAT on its own.
+    bool solve(const std::vector<Literal>& assumptions);
+    const std::vector<Literal>& failed_assumptions() const { return failed_assumptions_; }
+
     void add_clause(const std::vector<Literal>& literals);
+    void add_clause(std::initializer_list<Literal> literals);
+    // The literals are only read during the call
+    void add_clause(const Literal* literals, size_t size);
+    // Clause i is literals[offsets[i]] up to literals[offsets[i + 1]]; the
+    // arena and every watch list grow once for the whole batch
+    void add_clauses(const Literal* literals, const size_t* offsets, size_t num_clauses);
     void add_unit_clause(const Literal& lit);
+    // Adds every clause and XOR of the formula, growing the variables to
+    // cover it
+    void add_formula(Formula formula);
+
+    // Constraint groups: clauses and XORs added to a group hold until the
+    // group is released, after which they are retracted for good together
+    // with every learnt clause that mentions them. Each group is guarded by
+    // activation variables allocated after the existing ones.
+    uint32_t new_group();
+    void add_clause(const std::vector<Literal>& literals, uint32_t group);
+    void add_xor(const std::vector<Literal>& xor_lits, uint32_t group);
+    void release_group(uint32_t group);
+    // A disabled group is suspended, not retracted: its constraints and the
+    // clauses learnt from them come back when it is enabled again
+    void set_group_enabled(uint32_t group, bool enabled);
 
+    // Simplifies the clauses in place (see Preprocessor); false if the
+    // formula turned out UNSAT. Variables outside frozen may be eliminated:
+    // they must not occur in clauses, XORs or assumptions added afterwards,
+    // and get_model() still assigns them. Learnt clauses are dropped.
+    // Call it before creating any group.
+    bool preprocess(const std::vector<uint32_t>& frozen, const PreprocessOptions& options = {});
+    const PreprocessStats& preprocess_stats() const { return preprocessor_.stats(); }
+
+    // Replaces the restart strategy (Glucose-style by default); nullptr
+    // disables restarts.
+    void set_restart_policy(std::unique_ptr<RestartPolicy> policy);
+
+    // Adds the constraint "XOR of xor_lits is true", handled natively by
+    // Gauss-Jordan elimination instead of being expanded into CNF.
+    void add_xor(const std::vector<Literal>& xor_lits);
+
+    // With the native engine disabled, add_xor encodes XORs into CNF
+    void set_native_xor(bool enabled) { native_xor_ = enabled; }
+    // Widest chunk of the CNF encoding, 3 to 5 (default 4)
+    void set_xor_chunk_width(uint32_t width);
+
+    // Appends a CNF encoding of "XOR of xor_lits is true". XORs wider than
+    // the chunk width are cut into a chain of chunks linked by auxiliary
+    // variables, allocated with new_var(), so the encoding has O(n)
+    // clauses instead of 2^(n-1).
     void convert_xor_to_cnf(
         const std::vector<Literal>& xor_lits,
         std::vector<std::vector<Literal>>& cnf_clauses
     );
 
+    // Master seed of every random choice, drawn from std::random_device by
+    // default. With a fixed seed solve_smc draws the same hashes for any
+    // number of threads.
+    void set_seed(uint64_t seed) { seed_ = seed; }
+
     bool solve_smc(
         const std::vector<uint32_t>& thresholds,
         const std::vector<std::vector<uint32_t>>& counting_variables,
@@ -28,53 +165,332 @@ public:
         int num_xor_tries = 10,
         double confidence = 0.99
     );
+    // Trials of all thresholds are independent; with several threads they
+    // run concurrently, each worker reusing one solver, and a threshold
+    // stops scheduling trials once its majority vote is decided.
+    //
+    // With fixed variables the query becomes: is there an assignment to
+    // them under which every threshold holds? It is answered by a single
+    // joint solve, where each trial of threshold i is a copy of the formula
+    // sharing only fixed_variables[i], with its own hash over its copy of
+    // the counting variables, and a majority of the copies of every
+    // threshold must be satisfied. All trials are built up front, so the
+    // options' thread count and early stopping do not apply, and each
+    // threshold with XORs costs num_xor_tries copies of the (simplified)
+    // formula, rounded up to an odd count; confidence and bias do not
+    // raise it. On success smc_witness() holds the fixed assignment found.
+    bool solve_smc(
+        const std::vector<uint32_t>& thresholds,
+        const std::vector<std::vector<uint32_t>>& counting_variables,
+        const std::vector<std::vector<uint32_t>>& fixed_variables,
+        const SmcOptions& options
+    );
+    // Assignment to the fixed variables of the last successful solve_smc
+    const std::vector<Literal>& smc_witness() const { return smc_witness_; }
+    // Verdict of every threshold in one pass. Thresholds on the same
+    // counting set share their trials: each trial draws one nested hash,
+    // where the XORs for q are a prefix of those for q + 1, so being SAT
+    // is monotone in q and a binary search over the thresholds' XOR counts
+    // answers all of them.
+    std::vector<bool> solve_smc_sweep(
+        const std::vector<uint32_t>& thresholds,
+        const std::vector<std::vector<uint32_t>>& counting_variables,
+        const SmcOptions& options = {}
+    );
 
+    // The model found by the last solve(); empty unless it returned true
     std::vector<bool> get_model() const;
     void add_blocking_clause(const std::vector<bool>& model);
+    // Blocks the model's assignment to the projection variables only
+    void add_blocking_clause(const std::vector<bool>& model, const std::vector<uint32_t>& projection);
+
+    // Approximate number of distinct assignments to counting_vars that
+    // extend to a model (ApproxMC): solutions are enumerated, up to a
+    // threshold, in one cell of a random XOR hash, searching for the
+    // number of XORs that leaves fewer than the threshold and taking the
+    // median over independent hashes. Works on a copy of the problem.
+    CountResult count(const std::vector<uint32_t>& counting_vars, const CountOptions& options = {});
     bool get_value(uint32_t var_id) const;
     uint32_t num_variables() const;
     uint32_t num_clauses() const;
 
+    // Counters since construction or the last reset_stats()
+    SolverStats stats() const;
+    void reset_stats();
+    // Votes, trials and solver counters of the last solve_smc or
+    // solve_smc_sweep call
+    const SmcStats& smc_stats() const { return smc_stats_; }
+
 private:
+    using ClauseRef = uint32_t;
+    static constexpr ClauseRef kNoClause = UINT32_MAX;
+
+    // Binary clauses have no arena storage. A reason with this bit set
+    // holds the watch index of the other (false) literal of the clause.
+    static constexpr ClauseRef kBinaryReason = 1u << 31;
+
+    class ClauseAllocator;
+
+    // Learnt clause tiers: core clauses are kept forever, tier-2 clauses
+    // while they keep being used, local ones are reduced by activity.
+    enum class Tier : uint32_t { Core = 0, Tier2 = 1, Local = 2 };
+    static constexpr uint32_t kCoreLbd = 2;
+    static constexpr uint32_t kTier2Lbd = 6;
+    static constexpr size_t kBinaryMinimizeSize = 30;
+
+    // Clause header stored inline in the arena, immediately followed by
+    // its literals. The two watched literals are kept at positions 0 and 1.
+    // Learnt clauses carry one extra word after the literals for activity.
     class Clause {
     public:
-        explicit Clause(const std::vector<Literal>& lits) 
-            : literals(lits), watched{0, 1} {}
-        
-        std::vector<Literal> literals;
-        std::array<size_t, 2> watched;
+        uint32_t size() const { return size_; }
+        bool learnt() const { return flags_ & kLearnt; }
+        bool is_xor_reason() const { return flags_ & kXorReason; }
+        bool removed() const { return flags_ & kRemoved; }
+        bool reloced() const { return flags_ & kReloced; }
+
+        uint32_t lbd() const { return flags_ >> kLbdShift; }
+        void set_lbd(uint32_t lbd) {
+            if (lbd > kMaxLbd) lbd = kMaxLbd;
+            flags_ = (flags_ & ((1u << kLbdShift) - 1)) | (lbd << kLbdShift);
+        }
+        Tier tier() const { return static_cast<Tier>((flags_ >> kTierShift) & 3); }
+        void set_tier(Tier tier) {
+            flags_ = (flags_ & ~(3u << kTierShift)) | (static_cast<uint32_t>(tier) << kTierShift);
+        }
+        bool used() const { return flags_ & kUsed; }
+        void set_used(bool used) { flags_ = used ? (flags_ | kUsed) : (flags_ & ~kUsed); }
+        float& activity() { return *reinterpret_cast<float*>(end()); }
+        float activity() const { return *reinterpret_cast<const float*>(end()); }
+
+        Literal* begin() { return reinterpret_cast<Literal*>(this + 1); }
+        Literal* end() { return begin() + size_; }
+        const Literal* begin() const { return reinterpret_cast<const Literal*>(this + 1); }
+        const Literal* end() const { return begin() + size_; }
+        Literal& operator[](uint32_t i) { return begin()[i]; }
+        const Literal& operator[](uint32_t i) const { return begin()[i]; }
+
+    private:
+        friend class ClauseAllocator;
+        static constexpr uint32_t kLearnt = 1u << 0;
+        static constexpr uint32_t kXorReason = 1u << 1;
+        static constexpr uint32_t kRemoved = 1u << 2;
+        static constexpr uint32_t kReloced = 1u << 3;
+        static constexpr uint32_t kTierShift = 4;
+        static constexpr uint32_t kUsed = 1u << 6;
+        static constexpr uint32_t kLbdShift = 8;
+        static constexpr uint32_t kMaxLbd = (1u << (32 - kLbdShift)) - 1;
+
+        uint32_t size_;
+        uint32_t flags_;
+    };
+
+    // Contiguous clause storage addressed by 32-bit word offsets. Freed
+    // clauses only count as wasted until the owner compacts the arena by
+    // relocating every live reference into a fresh allocator.
+    class ClauseAllocator {
+    public:
+        static constexpr uint32_t kHeaderWords = sizeof(Clause) / sizeof(uint32_t);
+
+        ClauseRef alloc(const Literal* lits, uint32_t size, bool learnt, bool xor_reason = false);
+        void free(ClauseRef ref);
+        void reloc(ClauseRef& ref, ClauseAllocator& to);
+
+        Clause& operator[](ClauseRef ref) { return *reinterpret_cast<Clause*>(memory_.data() + ref); }
+        const Clause& operator[](ClauseRef ref) const {
+            return *reinterpret_cast<const Clause*>(memory_.data() + ref);
+        }
+
+        size_t size() const { return memory_.size(); }
+        size_t wasted() const { return wasted_; }
+        void reserve(size_t words) { memory_.reserve(words); }
+        // Appends clauses laid out as in the arena, taking over the words
+        // without a copy when the arena is empty; returns where they start
+        ClauseRef adopt(std::vector<uint32_t>&& words);
+
+    private:
+        std::vector<uint32_t> memory_;
+        size_t wasted_ = 0;
+    };
+
+    // Watch list entry. If the blocker literal is true the clause is
+    // satisfied and does not need to be visited.
+    struct Watcher {
+        ClauseRef cref;
+        Literal blocker;
+    };
+
+    static constexpr uint32_t kNoVar = UINT32_MAX;
+
+    // Variables of a constraint group. All clauses of the group
+    // share one variable, each XOR gets its own; solve() assumes all of
+    // them false while the group is active.
+    struct Group {
+        std::vector<uint32_t> activation_vars;
+        std::vector<uint32_t> aux_vars;  // Chunk links of CNF-encoded XORs
+        uint32_t clause_var;
+        bool has_clauses;  // Some of its constraints are stored as clauses
+        bool enabled;
+        bool released;
     };
 
     struct Assignment {
         int level;
         bool value;
-        std::shared_ptr<Clause> reason;
+        ClauseRef reason;
     };
 
-    void attach_watch(const std::shared_ptr<Clause>& clause, size_t watch_idx);
-    void detach_watch(const std::shared_ptr<Clause>& clause, size_t watch_idx);
-    bool update_watches(const std::shared_ptr<Clause>& clause, const Literal& false_lit);
+    void grow_variables(uint32_t num_vars);
+    uint32_t new_internal_var();
+    void remove_clauses_with(const std::vector<uint32_t>& vars, bool originals);
+    // Drops every original, binary and learnt clause; level-0 assignments
+    // and XORs stay
+    void clear_clauses();
+    // Level-0 units, binaries, original clauses and XORs as a formula
+    Formula snapshot() const;
+    // snapshot() simplified with the frozen variables kept
+    Formula simplified_snapshot(const std::vector<uint32_t>& frozen, PreprocessStats& stats) const;
+    // Sets up to, which must be empty, with this solver's settings on base
+    void copy_problem_to(Solver& to, Formula base) const;
+    // Adds a copy of the problem with every variable renamed through
+    // var_map, holding only while selector is true
+    void copy_guarded_to(Solver& to, const std::vector<uint32_t>& var_map, uint32_t selector) const;
 
-    bool assign(uint32_t var, bool value, int level, const std::shared_ptr<Clause>& reason);
+    static XorConstraint normalize_xor(const std::vector<Literal>& xor_lits);
+    void encode_xor(const XorConstraint& constraint, std::vector<std::vector<Literal>>& cnf_clauses,
+                    std::vector<uint32_t>* internal_aux);
+    static void expand_xor_chunk(const std::vector<uint32_t>& vars, bool rhs,
+                                 std::vector<std::vector<Literal>>& cnf_clauses);
+    void add_hash_row(const XorConstraint& row, uint32_t group);
+    bool run_smc_trial(const std::vector<XorConstraint>& hash);
+    bool solve_smc_joint(const std::vector<uint32_t>& thresholds,
+                         const std::vector<std::vector<uint32_t>>& counting_variables,
+                         const std::vector<std::vector<uint32_t>>& fixed_variables,
+                         const SmcOptions& options);
+    size_t run_sweep_trial(const std::vector<XorConstraint>& rows, const std::vector<int>& num_xors);
+    uint32_t count_cell(const std::vector<uint32_t>& counting_vars, uint32_t limit);
+    CountResult search_hash_count(const std::vector<uint32_t>& counting_vars, uint32_t threshold,
+                                  const CountOptions& options, std::mt19937_64& rng,
+                                  uint32_t start);
+
+    ClauseRef add_clause_to_arena(const std::vector<Literal>& literals, bool learnt);
+    // Simplifies an original clause against level 0 and stores it. Units
+    // are assigned and binaries linked; a longer clause is returned
+    // unwatched, or kNoClause if nothing was left to store.
+    ClauseRef store_clause(const Literal* literals, size_t size);
+    // Watches clauses_ from first on, sizing each watch list in advance
+    void attach_originals(size_t first);
+    void add_binary(const Literal& a, const Literal& b);
+    void attach_watches(ClauseRef cref);
+
+    static uint32_t watch_index(const Literal& lit) { return lit.var_id() * 2 + !lit.is_positive(); }
+    static Literal literal_at(uint32_t index) { return Literal(index >> 1, !(index & 1)); }
+    static ClauseRef binary_reason(const Literal& other) { return kBinaryReason | watch_index(other); }
+    static bool is_binary_reason(ClauseRef reason) {
+        return reason != kNoClause && (reason & kBinaryReason);
+    }
+    bool is_arena_reason(ClauseRef reason) const {
+        return reason != kNoClause && !(reason & kBinaryReason);
+    }
+    bool is_true(const Literal& lit) const {
+        const Assignment& a = assignments_[lit.var_id()];
+        return a.level != -1 && a.value == lit.is_positive();
+    }
+    bool is_false(const Literal& lit) const {
+        const Assignment& a = assignments_[lit.var_id()];
+        return a.level != -1 && a.value != lit.is_positive();
+    }
+
+    bool assign(uint32_t var, bool value, int level, ClauseRef reason);
     void unassign(uint32_t var);
     bool propagate();
+    bool propagate_binary(const Literal& false_lit);
+    bool propagate_long(const Literal& false_lit);
+    bool propagate_xors();
+    bool enqueue_xor_implications();
 
-    std::shared_ptr<Clause> analyze_conflict(const std::shared_ptr<Clause>& conflict);
-    int compute_backtrack_level(const std::shared_ptr<Clause>& learnt_clause);
+    LiteralSpan reason_literals(uint32_t var);
+    LiteralSpan conflict_literals();
+    void analyze_conflict(std::vector<Literal>& learnt_clause);
+    // For assertions: every literal false, the asserting one first at the
+    // conflict level, the highest of the rest second, no variable twice
+    bool learnt_clause_ordered(const std::vector<Literal>& learnt_clause) const;
+    void analyze_final(const Literal& assumption);
+    bool literal_redundant(const Literal& lit, uint32_t abstract_levels);
+    void minimize_with_binaries(std::vector<Literal>& learnt_clause);
+    uint32_t abstract_level(uint32_t var) const { return 1u << (assignments_[var].level & 31); }
+    int compute_backtrack_level(const std::vector<Literal>& learnt_clause);
+    template <typename Lits>
+    uint32_t compute_lbd(const Lits& literals);
     void backtrack(int level);
 
-    void print_clause(const std::shared_ptr<Clause>& clause) const;
+    // EVSIDS: bumps grow geometrically instead of decaying every activity
+    void bump_activity(uint32_t var);
+    void decay_activities();
+    int pick_branch_var();
+
+    void bump_clause_activity(Clause& clause);
+    void update_learnt_clause(ClauseRef cref);
+    bool locked(ClauseRef cref) const;
+    void reduce_db();
+    void purge_watches(uint32_t index);
+
+    void check_garbage();
+    void garbage_collect();
+
+    void print_clause(ClauseRef cref) const;
     void print_assignment() const;
 
+    ClauseAllocator ca_;
     std::vector<Assignment> assignments_;
-    std::vector<std::shared_ptr<Clause>> clauses_;
-    std::vector<std::vector<std::shared_ptr<Clause>>> watches_;
+    std::vector<ClauseRef> clauses_;
+    std::vector<ClauseRef> learnts_;
+    std::vector<std::vector<Watcher>> watches_;  // Clauses watching each literal
+    std::vector<std::vector<Literal>> binary_watches_;  // Implied literals when the indexed one is false
+    uint32_t num_binary_;
     std::vector<uint32_t> trail_;
-    std::vector<uint32_t> propagation_queue_;
-    std::vector<bool> seen_;
-    std::shared_ptr<Clause> conflict_clause_;
+    size_t qhead_;      // Next trail entry for long-clause propagation
+    size_t bin_qhead_;  // Next trail entry for binary propagation
+    std::vector<uint8_t> seen_;  // Per-variable marks used by conflict analysis
+    std::vector<Literal> learnt_clause_;
+    std::vector<Literal> analyze_stack_;
+    std::vector<Literal> analyze_toclear_;
+    ClauseRef conflict_clause_;
+    Literal conflict_binary_[2];
+    Literal reason_buffer_[2];
+    bool ok_;  // False once the empty clause has been derived
     int decision_level_;
-    std::mt19937 rng_;
+    std::vector<double> activity_;
+    double var_inc_;
+    double var_decay_;
+    VarHeap order_heap_;
+    std::vector<bool> polarity_;  // Saved phase of each variable
+    std::unique_ptr<RestartPolicy> restart_policy_;
+    std::vector<uint64_t> level_stamp_;  // Scratch for counting distinct levels
+    uint64_t lbd_stamp_;
+    double clause_inc_;
+    double clause_decay_;
+    uint64_t num_conflicts_;
+    uint64_t next_reduce_;     // Conflict count that triggers the next reduce_db
+    uint64_t reduce_interval_;
+    XorEngine xor_engine_;
+    bool native_xor_;
+    uint32_t xor_chunk_width_;
+    size_t xor_qhead_;  // Trail entries already fed to xor_engine_
+    std::vector<Literal> add_buffer_;
+    std::vector<Literal> assumptions_;  // User assumptions, then active group guards
+    std::vector<Literal> failed_assumptions_;
+    std::vector<Group> groups_;
+    std::vector<uint8_t> is_internal_;
+    std::vector<uint32_t> free_internal_vars_;  // Released and unassigned, ready for reuse
+    std::vector<bool> model_;
+    Preprocessor preprocessor_;  // Variables eliminated by preprocess(), restored in every model
+    std::vector<Literal> smc_witness_;
+    uint64_t seed_;
+    SolverStats stats_;
+    SmcStats smc_stats_;
+    const std::atomic<bool>* interrupt_;  // solve() gives up once this is set
+    bool interrupted_;
 };
 
 } 
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Statistics counters compile to nothing when XOR_SMC_NO_STATS is defined
+// (the XOR_SMC_STATS CMake option); the structs stay, left at zero.
+#ifdef XOR_SMC_NO_STATS
+#define XOR_SMC_STAT(statement) do {} while (0)
+#else
+#define XOR_SMC_STAT(statement) do { statement; } while (0)
+#endif
+
+namespace xor_smc {
+
+// Bin i counts the value i, the last bin every larger value too
+constexpr size_t kHistogramBins = 32;
+using Histogram = std::array<uint64_t, kHistogramBins>;
+
+inline void histogram_add(Histogram& histogram, uint64_t value) {
+    histogram[value < kHistogramBins ? value : kHistogramBins - 1]++;
+}
+
+struct XorStats {
+    uint64_t builds = 0;         // Gauss-Jordan eliminations from scratch
+    uint64_t row_additions = 0;  // Row XORs, while building or pivoting
+    uint64_t pivots = 0;         // Basic column changes during search
+    uint64_t implications = 0;
+    uint64_t conflicts = 0;
+};
+
+struct SolverStats {
+    uint64_t solves = 0;
+    uint64_t decisions = 0;
+    uint64_t propagations = 0;  // Assignments whose clauses were visited
+    uint64_t conflicts = 0;
+    uint64_t restarts = 0;
+    uint64_t reductions = 0;  // Learnt clause database reductions
+    uint64_t watch_visits = 0;         // Long clause watchers inspected
+    uint64_t binary_watch_visits = 0;  // Implicit binary implications inspected
+    uint64_t learnt_literals = 0;
+    Histogram learnt_size_histogram{};
+    Histogram lbd_histogram{};
+    XorStats xor_stats;
+
+    // Wall time of whole solve() calls, and of the phases within them
+    double solve_seconds = 0;
+    double analyze_seconds = 0;
+    double reduce_seconds = 0;
+    double garbage_collect_seconds = 0;
+    double xor_build_seconds = 0;
+
+    size_t peak_clause_bytes = 0;  // Largest the clause arena has been
+
+    // Sums two runs; the peak is the larger of the two
+    SolverStats& operator+=(const SolverStats& other);
+};
+
+struct PreprocessStats {
+    uint64_t clauses_before = 0;
+    uint64_t clauses_after = 0;
+    uint64_t eliminated_vars = 0;
+    uint64_t substituted_vars = 0;  // Replaced by an equivalent literal
+    uint64_t resolvents = 0;
+    uint64_t subsumed = 0;      // Clauses removed by subsumption
+    uint64_t strengthened = 0;  // Literals removed by self-subsuming resolution
+    uint64_t failed_literals = 0;
+    uint64_t units = 0;  // Top-level units found while simplifying
+    double seconds = 0;
+};
+
+struct SmcTrialStats {
+    int trial;
+    bool sat;
+    double seconds;
+    uint64_t decisions;
+    uint64_t conflicts;
+    uint64_t propagations;
+};
+
+struct SmcThresholdStats {
+    uint32_t threshold = 0;
+    int num_xors = 0;
+    int successes = 0;
+    int failures = 0;
+    bool decided = false;
+    bool passed = false;
+    // Completed trials in trial order; a trial interrupted because the
+    // vote was already decided is not listed
+    std::vector<SmcTrialStats> trials;
+    // Summed over the trials; a sweep trial serves several thresholds and
+    // is counted in each
+    SolverStats solver;
+};
+
+struct SmcStats {
+    double seconds = 0;
+    std::vector<SmcThresholdStats> thresholds;
+    SolverStats solver;  // Every solve the query ran
+    PreprocessStats preprocess;  // Of the base formula the trials share
+};
+
+// Adds the lifetime of the scope to total
+#ifdef XOR_SMC_NO_STATS
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double&) {}
+};
+#else
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double& total) : total_(total), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        total_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    double& total_;
+    std::chrono::steady_clock::time_point start_;
+};
+#endif
+
+}
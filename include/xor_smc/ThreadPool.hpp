@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xor_smc {
+
+// Fixed-size pool of workers, each with its own task deque. A worker runs
+// its own tasks oldest first and steals the oldest task of another worker
+// when its deque is empty, so tasks start roughly in submission order.
+// Tasks receive the index of the worker running them so
+// they can use per-worker state without locking.
+class ThreadPool {
+public:
+    using Task = std::function<void(unsigned worker)>;
+
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return threads_.size(); }
+
+    // Tasks are spread round-robin over the worker deques
+    void submit(Task task);
+    // Blocks until every submitted task has finished
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned worker);
+    bool take(unsigned worker, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    size_t queued_ = 0;   // Submitted but not yet claimed by a worker
+    size_t pending_ = 0;  // Submitted but not yet finished
+    unsigned next_queue_ = 0;
+    bool stop_ = false;
+};
+
+}
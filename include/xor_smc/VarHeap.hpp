@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace xor_smc {
+
+// Indexed binary max-heap of variables keyed by an external activity array,
+// giving O(log n) insert, pop and key increase.
+class VarHeap {
+public:
+    bool empty() const { return heap_.empty(); }
+    bool contains(uint32_t var) const {
+        return var < index_.size() && index_[var] != kAbsent;
+    }
+
+    void grow(uint32_t num_vars) {
+        if (index_.size() < num_vars) index_.resize(num_vars, kAbsent);
+    }
+
+    void insert(uint32_t var, const std::vector<double>& activity) {
+        grow(var + 1);
+        if (contains(var)) return;
+        index_[var] = heap_.size();
+        heap_.push_back(var);
+        sift_up(index_[var], activity);
+    }
+
+    // Restores the heap after activity[var] increased
+    void increased(uint32_t var, const std::vector<double>& activity) {
+        if (contains(var)) sift_up(index_[var], activity);
+    }
+
+    uint32_t pop_max(const std::vector<double>& activity) {
+        uint32_t top = heap_[0];
+        heap_[0] = heap_.back();
+        index_[heap_[0]] = 0;
+        index_[top] = kAbsent;
+        heap_.pop_back();
+        if (!heap_.empty()) sift_down(0, activity);
+        return top;
+    }
+
+private:
+    static constexpr uint32_t kAbsent = UINT32_MAX;
+
+    void sift_up(uint32_t pos, const std::vector<double>& activity) {
+        uint32_t var = heap_[pos];
+        while (pos > 0) {
+            uint32_t parent = (pos - 1) / 2;
+            if (activity[heap_[parent]] >= activity[var]) break;
+            heap_[pos] = heap_[parent];
+            index_[heap_[pos]] = pos;
+            pos = parent;
+        }
+        heap_[pos] = var;
+        index_[var] = pos;
+    }
+
+    void sift_down(uint32_t pos, const std::vector<double>& activity) {
+        uint32_t var = heap_[pos];
+        uint32_t size = heap_.size();
+        while (2 * pos + 1 < size) {
+            uint32_t child = 2 * pos + 1;
+            if (child + 1 < size && activity[heap_[child + 1]] > activity[heap_[child]]) child++;
+            if (activity[heap_[child]] <= activity[var]) break;
+            heap_[pos] = heap_[child];
+            index_[heap_[pos]] = pos;
+            pos = child;
+        }
+        heap_[pos] = var;
+        index_[var] = pos;
+    }
+
+    std::vector<uint32_t> heap_;
+    std::vector<uint32_t> index_;  // Position in heap_, kAbsent if not queued
+};
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "Literal.hpp"
+#include "Stats.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace xor_smc {
+
+// A parity constraint: the XOR of vars equals rhs.
+struct XorConstraint {
+    std::vector<uint32_t> vars;
+    bool rhs;
+};
+
+// Bit-packed GF(2) matrix over the variables that occur in XOR constraints,
+// kept in reduced row echelon form. Every row has one basic column that
+// appears in no other row; the basic column is kept unassigned while the row
+// still has unassigned columns (re-pivoting when it gets assigned), so a row
+// whose only unassigned column is its basic one implies that column. Each
+// column lists the rows that contain it, so an assignment only visits
+// those rows.
+class XorEngine {
+public:
+    struct Implication {
+        Literal lit;
+        uint32_t reason_begin;  // offset into reason_literals()
+        uint32_t reason_size;
+    };
+
+    void add(const XorConstraint& constraint);
+    void clear();
+    // Drops every constraint that mentions one of vars
+    void remove_containing(const std::vector<uint32_t>& vars);
+    bool empty() const { return constraints_.empty(); }
+    const std::vector<XorConstraint>& constraints() const { return constraints_; }
+
+    // (Re)builds the matrix by Gauss-Jordan elimination with every column
+    // unassigned. Returns false if the system is inconsistent.
+    bool build(uint32_t num_vars);
+    bool needs_build() const { return needs_build_; }
+    uint32_t num_rows() const { return num_rows_; }
+
+    // Feeds one assignment in trail order. Returns false on conflict, in
+    // which case conflict() holds a clause falsified by the assignment.
+    bool assign(uint32_t var, bool value);
+    void unassign(uint32_t var);
+
+    // Re-checks the rows of the columns unassigned since the last call and
+    // the rows a conflict left unchecked; used after backtracking to find
+    // implications that became available at a lower level.
+    bool recheck();
+    bool dirty() const { return dirty_; }
+
+    // Implications produced by assign()/recheck(). Reasons are clauses with
+    // the implied literal first and every other literal false.
+    const std::vector<Implication>& implications() const { return implications_; }
+    const Literal* reason_literals(const Implication& imp) const {
+        return reason_lits_.data() + imp.reason_begin;
+    }
+    void clear_implications();
+
+    const std::vector<Literal>& conflict() const { return conflict_; }
+
+    const XorStats& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+private:
+    static constexpr int32_t kNone = -1;
+
+    uint64_t* row(uint32_t r) { return rows_.data() + static_cast<size_t>(r) * words_; }
+    const uint64_t* row(uint32_t r) const { return rows_.data() + static_cast<size_t>(r) * words_; }
+    bool has_col(uint32_t r, uint32_t col) const {
+        return (row(r)[col >> 6] >> (col & 63)) & 1;
+    }
+    bool col_assigned(uint32_t col) const { return (assigned_[col >> 6] >> (col & 63)) & 1; }
+
+    void pivot(uint32_t r, uint32_t col);
+    bool check_row(uint32_t r);
+    bool process_worklist();
+    void push_row(uint32_t r);
+    void push_rows_of(uint32_t col);
+    void push_unassigned();
+    void explain_row(uint32_t r, int32_t implied_col, bool implied_value);
+
+    std::vector<XorConstraint> constraints_;
+
+    std::vector<int32_t> col_of_var_;
+    std::vector<uint32_t> var_of_col_;
+    uint32_t num_cols_ = 0;
+    uint32_t words_ = 0;
+
+    std::vector<uint64_t> rows_;
+    std::vector<uint8_t> rhs_;
+    std::vector<int32_t> basic_col_;     // per row
+    std::vector<int32_t> row_of_basic_;  // per column, kNone if non-basic
+    uint32_t num_rows_ = 0;
+
+    // Rows of each column; pivoting only appends, so rows that lost the
+    // column and repeats are dropped when the column is next visited
+    std::vector<std::vector<uint32_t>> col_rows_;
+    std::vector<uint32_t> row_stamp_;
+    uint32_t stamp_ = 0;
+
+    std::vector<uint64_t> assigned_;
+    std::vector<uint64_t> values_;
+
+    std::vector<uint32_t> worklist_;
+    std::vector<uint8_t> in_worklist_;
+    std::vector<uint32_t> unassigned_cols_;  // Since the last recheck()
+
+    std::vector<Implication> implications_;
+    std::vector<Literal> reason_lits_;
+    std::vector<Literal> conflict_;
+
+    bool needs_build_ = false;
+    bool dirty_ = false;
+    XorStats stats_;
+};
+
+}
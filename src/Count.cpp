@@ -0,0 +1,151 @@
+#include "xor_smc/Solver.hpp"
+#include "xor_smc/Log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace xor_smc {
+
+namespace {
+
+// Cell size bound and number of repetitions of ApproxMC (Chakraborty,
+// Meel and Vardi, IJCAI 2016)
+uint32_t cell_threshold(double epsilon) {
+    double factor = 1.0 + 1.0 / epsilon;
+    return 1 + static_cast<uint32_t>(std::ceil(9.84 * (1.0 + epsilon / (1.0 + epsilon)) * factor * factor));
+}
+
+int num_repetitions(double delta) {
+    return static_cast<int>(std::ceil(17.0 * std::log2(3.0 / delta)));
+}
+
+double log2_estimate(const CountResult& result) {
+    if (result.cell_count == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return std::log2(static_cast<double>(result.cell_count)) + result.num_hashes;
+}
+
+}
+
+double CountResult::estimate() const {
+    return std::ldexp(static_cast<double>(cell_count), num_hashes);
+}
+
+CountResult Solver::count(const std::vector<uint32_t>& counting_vars, const CountOptions& options) {
+    Solver counter;
+    PreprocessStats preprocess_stats;
+    copy_problem_to(counter, options.preprocess ? simplified_snapshot(counting_vars, preprocess_stats) : snapshot());
+    uint32_t threshold = cell_threshold(options.epsilon);
+
+    // Few enough solutions are counted exactly
+    uint32_t solutions = counter.count_cell(counting_vars, threshold);
+    if (solutions < threshold) {
+        XOR_SMC_INFO("Exact count: " << solutions);
+        return {solutions, 0, true};
+    }
+
+    std::vector<CountResult> estimates;
+    uint32_t num_hashes = 1;
+    int repetitions = num_repetitions(options.delta);
+    for (int i = 0; i < repetitions; i++) {
+        std::mt19937_64 rng(splitmix64(seed_ ^ splitmix64(i)));
+        CountResult result = counter.search_hash_count(counting_vars, threshold, options, rng, num_hashes);
+        num_hashes = std::max(result.num_hashes, 1u);
+        estimates.push_back(result);
+    }
+
+    auto median = estimates.begin() + estimates.size() / 2;
+    std::nth_element(estimates.begin(), median, estimates.end(),
+                     [](const CountResult& a, const CountResult& b) {
+                         return log2_estimate(a) < log2_estimate(b);
+                     });
+    XOR_SMC_INFO("Approximate count: " << median->cell_count << " * 2^" << median->num_hashes);
+    return *median;
+}
+
+uint32_t Solver::count_cell(const std::vector<uint32_t>& counting_vars, uint32_t limit) {
+    // Blocking clauses only live as long as the cell is being counted
+    uint32_t blocking = new_group();
+    uint32_t solutions = 0;
+    while (solutions < limit && solve()) {
+        solutions++;
+        std::vector<Literal> clause;
+        for (uint32_t var : counting_vars) {
+            clause.push_back(Literal(var, !model_[var]));
+        }
+        add_clause(clause, blocking);
+    }
+    release_group(blocking);
+    return solutions;
+}
+
+CountResult Solver::search_hash_count(const std::vector<uint32_t>& counting_vars, uint32_t threshold,
+                                      const CountOptions& options, std::mt19937_64& rng,
+                                      uint32_t start) {
+    // Every number of XORs uses a prefix of the same hash, one group per
+    // row, so moving between them only enables or disables groups. Sparse
+    // rows get the density of the full hash, the highest any prefix needs.
+    uint32_t n = counting_vars.size();
+    std::vector<XorConstraint> rows = draw_hash(options.hash, counting_vars, n, options.sparse_density, rng);
+    std::vector<uint32_t> row_groups;
+    std::vector<int64_t> cell_counts(n + 1, -1);
+
+    auto cell_count = [&](uint32_t m) {
+        if (cell_counts[m] < 0) {
+            while (row_groups.size() < m) {
+                row_groups.push_back(new_group());
+                add_hash_row(rows[row_groups.size() - 1], row_groups.back());
+            }
+            for (size_t i = 0; i < row_groups.size(); i++) {
+                set_group_enabled(row_groups[i], i < m);
+            }
+            cell_counts[m] = count_cell(counting_vars, threshold);
+        }
+        return static_cast<uint32_t>(cell_counts[m]);
+    };
+
+    // Find the fewest XORs leaving a cell below the threshold. Invariant:
+    // cell_count(lo) >= threshold > cell_count(hi), where n + 1 stands
+    // for "not found yet". Gallop from the previous answer, then bisect.
+    uint32_t lo = 0;
+    uint32_t hi = n + 1;
+    uint32_t m = std::min(std::max(start, 1u), n);
+    if (cell_count(m) >= threshold) {
+        lo = m;
+        for (uint32_t step = 1; lo + step <= n; step *= 2) {
+            if (cell_count(lo + step) < threshold) {
+                hi = lo + step;
+                break;
+            }
+            lo += step;
+        }
+    } else {
+        hi = m;
+        for (uint32_t step = 1; step < hi; step *= 2) {
+            if (cell_count(hi - step) >= threshold) {
+                lo = hi - step;
+                break;
+            }
+            hi -= step;
+        }
+    }
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (cell_count(mid) < threshold) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+
+    for (uint32_t group : row_groups) {
+        release_group(group);
+    }
+
+    // Every XOR still leaving too many solutions settles for all of them
+    uint32_t num_hashes = std::min(hi, n);
+    return {static_cast<uint64_t>(cell_counts[num_hashes]), num_hashes, false};
+}
+
+}
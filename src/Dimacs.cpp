@@ -0,0 +1,283 @@
+#include "xor_smc/Dimacs.hpp"
+#include "xor_smc/Solver.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xor_smc {
+
+namespace {
+
+// Cursor over the input that keeps track of the line number for errors
+class Scanner {
+public:
+    Scanner(const char* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool at_end() const { return p_ == end_; }
+    char peek() const { return p_ < end_ ? *p_ : '\0'; }
+    void advance() { p_++; }
+    uint64_t line() const { return line_; }
+
+    // Spaces within the current line
+    void skip_blanks() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) {
+            p_++;
+        }
+    }
+
+    // Spaces and line breaks
+    void skip_space() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n')) {
+            line_ += *p_ == '\n';
+            p_++;
+        }
+    }
+
+    void skip_line() {
+        auto* newline = static_cast<const char*>(std::memchr(p_, '\n', end_ - p_));
+        if (newline == nullptr) {
+            p_ = end_;
+            return;
+        }
+        p_ = newline + 1;
+        line_++;
+    }
+
+    // Consumes word if it comes next as a whole token on this line
+    bool match(const char* word) {
+        skip_blanks();
+        size_t length = std::strlen(word);
+        if (static_cast<size_t>(end_ - p_) < length || std::memcmp(p_, word, length) != 0) {
+            return false;
+        }
+        const char* after = p_ + length;
+        if (after < end_ && !std::strchr(" \t\r\n", *after)) {
+            return false;
+        }
+        p_ = after;
+        return true;
+    }
+
+    // A decimal integer of magnitude at most limit, optionally negative.
+    // The caller skips the space before it.
+    bool read_int(int64_t& value, uint64_t limit) {
+        bool negative = p_ < end_ && *p_ == '-';
+        if (negative) {
+            p_++;
+        }
+        if (p_ == end_ || *p_ < '0' || *p_ > '9') {
+            return false;
+        }
+        uint64_t magnitude = 0;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            uint64_t digit = *p_++ - '0';
+            if (magnitude > (limit - digit) / 10) {
+                return false;
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+        value = negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+        return true;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    uint64_t line_ = 1;
+};
+
+// Owns a read-only mapping of a whole file
+class MappedFile {
+public:
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+    }
+
+    bool open(const std::string& path, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = "cannot stat " + path + ": " + std::strerror(errno);
+            close(fd);
+            return false;
+        }
+        size_ = st.st_size;
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                error = "cannot map " + path + ": " + std::strerror(errno);
+                close(fd);
+                return false;
+            }
+            data_ = data;
+            madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+        close(fd);
+        return true;
+    }
+
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Target is a Solver or a Formula
+template <typename Target>
+bool parse(const char* data, size_t size, Target& target, DimacsInfo& info) {
+    Scanner in(data, size);
+    std::vector<Literal> lits;  // Reused by every clause
+    uint32_t num_vars = target.num_variables();
+    bool has_header = false;
+
+    auto fail = [&](const char* what) {
+        info.error = "line " + std::to_string(in.line()) + ": " + what;
+        return false;
+    };
+    auto ensure_var = [&](uint32_t var) {
+        if (var >= num_vars) {
+            num_vars = var + 1;
+            target.set_num_variables(num_vars);
+        }
+    };
+
+    // Literals up to the terminating 0. Clauses and XORs may continue on
+    // the next lines; projection lists may not.
+    auto read_literals = [&](bool multiline) {
+        lits.clear();
+        while (true) {
+            if (multiline) {
+                in.skip_space();
+            } else {
+                in.skip_blanks();
+            }
+            if (in.at_end() || (!multiline && in.peek() == '\n')) {
+                return true;  // A missing final 0 is tolerated
+            }
+            // Literal holds variables below 2^31
+            int64_t value;
+            if (!in.read_int(value, 1u << 31)) {
+                return false;
+            }
+            if (value == 0) {
+                return true;
+            }
+            uint32_t var = static_cast<uint32_t>((value < 0 ? -value : value) - 1);
+            ensure_var(var);
+            lits.push_back(Literal(var, value > 0));
+        }
+    };
+
+    bool done = false;
+    while (!done) {
+        in.skip_space();
+        if (in.at_end()) {
+            break;
+        }
+        switch (in.peek()) {
+        case 'c':
+            in.advance();
+            if (in.match("ind") || (in.match("p") && in.match("show"))) {
+                if (!read_literals(false)) {
+                    return fail("expected a variable");
+                }
+                for (const Literal& lit : lits) {
+                    info.projection.push_back(lit.var_id());
+                }
+            }
+            in.skip_line();
+            break;
+        case 'p': {
+            in.advance();
+            if (has_header) {
+                return fail("second problem line");
+            }
+            if (!in.match("cnf")) {
+                return fail("expected \"p cnf\"");
+            }
+            int64_t vars;
+            int64_t clauses;
+            in.skip_blanks();
+            bool read = in.read_int(vars, 1u << 31);
+            in.skip_blanks();
+            if (!read || !in.read_int(clauses, INT64_MAX) || vars < 0 || clauses < 0) {
+                return fail("malformed problem line");
+            }
+            has_header = true;
+            info.num_variables = static_cast<uint32_t>(vars);
+            info.num_clauses = static_cast<uint64_t>(clauses);
+            if (info.num_variables > num_vars) {
+                num_vars = info.num_variables;
+                target.set_num_variables(num_vars);
+            }
+            in.skip_line();
+            break;
+        }
+        case 'x':
+            in.advance();
+            if (!read_literals(true)) {
+                return fail("expected a literal");
+            }
+            target.add_xor(lits);
+            info.xors_read++;
+            break;
+        case '%':
+            // End marker of the SATLIB benchmarks
+            done = true;
+            break;
+        default:
+            if (!read_literals(true)) {
+                return fail("expected a literal");
+            }
+            target.add_clause(lits);
+            info.clauses_read++;
+            break;
+        }
+    }
+
+    std::sort(info.projection.begin(), info.projection.end());
+    info.projection.erase(std::unique(info.projection.begin(), info.projection.end()),
+                          info.projection.end());
+    return true;
+}
+
+template <typename Target>
+bool load(const std::string& path, Target& target, DimacsInfo& info) {
+    MappedFile file;
+    if (!file.open(path, info.error)) {
+        return false;
+    }
+    return parse(file.data(), file.size(), target, info);
+}
+
+}
+
+bool load_dimacs(const std::string& path, Solver& solver, DimacsInfo& info) {
+    return load(path, solver, info);
+}
+
+bool load_dimacs(const std::string& path, Formula& formula, DimacsInfo& info) {
+    return load(path, formula, info);
+}
+
+bool parse_dimacs(const char* data, size_t size, Solver& solver, DimacsInfo& info) {
+    return parse(data, size, solver, info);
+}
+
+bool parse_dimacs(const char* data, size_t size, Formula& formula, DimacsInfo& info) {
+    return parse(data, size, formula, info);
+}
+
+}
@@ -1,3 +1,91 @@
 #include "xor_smc/Formula.hpp"
+#include <algorithm>
+
 namespace xor_smc {
+
+void Formula::add_clause(const std::vector<Literal>& literals) {
+    add_clause(literals.data(), literals.size());
+}
+
+void Formula::add_clause(std::initializer_list<Literal> literals) {
+    add_clause(literals.begin(), literals.size());
+}
+
+void Formula::add_clause(const Literal* literals, size_t size) {
+    buffer_.assign(literals, literals + size);
+    std::sort(buffer_.begin(), buffer_.end(), [](const Literal& a, const Literal& b) {
+        return a.var_id() < b.var_id() || (a.var_id() == b.var_id() && a.is_positive() < b.is_positive());
+    });
+    size_t j = 0;
+    for (size_t i = 0; i < buffer_.size(); i++) {
+        if (j > 0 && buffer_[j - 1].var_id() == buffer_[i].var_id()) {
+            if (buffer_[j - 1] != buffer_[i]) {
+                return;  // x ∨ ¬x
+            }
+            continue;
+        }
+        buffer_[j++] = buffer_[i];
+    }
+    buffer_.resize(j);
+
+    if (buffer_.empty()) {
+        has_empty_clause_ = true;
+        return;
+    }
+    num_vars_ = std::max(num_vars_, buffer_.back().var_id() + 1);
+
+    if (buffer_.size() == 1) {
+        units_.push_back(buffer_[0]);
+        return;
+    }
+    if (buffer_.size() == 2) {
+        binaries_.insert(binaries_.end(), buffer_.begin(), buffer_.end());
+        return;
+    }
+    offsets_.push_back(words_.size());
+    words_.push_back(buffer_.size());
+    words_.push_back(0);
+    for (const Literal& lit : buffer_) {
+        words_.push_back(reinterpret_cast<const uint32_t&>(lit));
+    }
+}
+
+void Formula::add_xor(const std::vector<Literal>& xor_lits) {
+    // x XOR ... = 1, with a negative literal flipping the parity; repeated
+    // variables cancel out
+    XorConstraint constraint{{}, true};
+    for (const Literal& lit : xor_lits) {
+        constraint.vars.push_back(lit.var_id());
+        if (!lit.is_positive()) constraint.rhs = !constraint.rhs;
+    }
+    std::sort(constraint.vars.begin(), constraint.vars.end());
+    size_t j = 0;
+    for (size_t i = 0; i < constraint.vars.size(); i++) {
+        if (i + 1 < constraint.vars.size() && constraint.vars[i] == constraint.vars[i + 1]) {
+            i++;
+            continue;
+        }
+        constraint.vars[j++] = constraint.vars[i];
+    }
+    constraint.vars.resize(j);
+
+    if (constraint.vars.empty()) {
+        if (constraint.rhs) {
+            has_empty_clause_ = true;
+        }
+        return;
+    }
+    num_vars_ = std::max(num_vars_, constraint.vars.back() + 1);
+    xors_.push_back(std::move(constraint));
+}
+
+void Formula::set_num_variables(uint32_t num_vars) {
+    num_vars_ = std::max(num_vars_, num_vars);
+}
+
+void Formula::reserve(size_t num_clauses, size_t num_literals) {
+    offsets_.reserve(num_clauses);
+    words_.reserve(num_clauses * kHeaderWords + num_literals);
+}
+
 }
@@ -0,0 +1,71 @@
+#include "xor_smc/Hash.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace xor_smc {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+double sparse_density(uint32_t num_vars, uint32_t num_rows) {
+    if (num_vars <= 2) {
+        return 0.5;
+    }
+    double n = num_vars;
+    double density = 2.0 * std::log2(n) / n * (1.0 + num_rows / n);
+    return std::min(0.5, density);
+}
+
+std::vector<XorConstraint> draw_hash(HashFamily family, const std::vector<uint32_t>& vars,
+                                     uint32_t num_rows, double density, std::mt19937_64& rng) {
+    std::bernoulli_distribution coin(0.5);
+    std::vector<XorConstraint> rows(num_rows);
+    if (num_rows == 0) {
+        return rows;
+    }
+
+    switch (family) {
+    case HashFamily::Dense:
+        density = 0.5;
+        break;
+    case HashFamily::Sparse:
+        if (density < 0) {
+            density = sparse_density(vars.size(), num_rows);
+        }
+        break;
+    case HashFamily::Toeplitz: {
+        // A[i][j] = diagonals[i - j + n - 1]
+        size_t n = vars.size();
+        std::vector<uint8_t> diagonals(n + num_rows - 1);
+        for (auto& bit : diagonals) {
+            bit = coin(rng);
+        }
+        for (uint32_t i = 0; i < num_rows; i++) {
+            for (size_t j = 0; j < n; j++) {
+                if (diagonals[i + n - 1 - j]) {
+                    rows[i].vars.push_back(vars[j]);
+                }
+            }
+            rows[i].rhs = coin(rng);
+        }
+        return rows;
+    }
+    }
+
+    std::bernoulli_distribution include(density);
+    for (auto& row : rows) {
+        for (uint32_t var : vars) {
+            if (include(rng)) {
+                row.vars.push_back(var);
+            }
+        }
+        row.rhs = coin(rng);
+    }
+    return rows;
+}
+
+}
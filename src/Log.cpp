@@ -0,0 +1,54 @@
+#include "xor_smc/Log.hpp"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace xor_smc {
+
+namespace {
+
+std::atomic<int> current_level{static_cast<int>(LogLevel::Off)};
+std::mutex sink_mutex;
+LogSink current_sink;
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Error: return "error";
+    case LogLevel::Warning: return "warning";
+    case LogLevel::Info: return "info";
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Trace: return "trace";
+    default: return "";
+    }
+}
+
+}
+
+void set_log_level(LogLevel level) {
+    current_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel log_level() {
+    return static_cast<LogLevel>(current_level.load(std::memory_order_relaxed));
+}
+
+void set_log_sink(LogSink sink) {
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    current_sink = std::move(sink);
+}
+
+bool log_enabled(LogLevel level) {
+    return level != LogLevel::Off &&
+           static_cast<int>(level) <= current_level.load(std::memory_order_relaxed);
+}
+
+void log_message(LogLevel level, const std::string& message) {
+    std::lock_guard<std::mutex> lock(sink_mutex);
+    if (current_sink) {
+        current_sink(level, message);
+    } else {
+        std::cerr << "[xor_smc " << level_name(level) << "] " << message << "\n";
+    }
+}
+
+}
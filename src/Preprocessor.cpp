@@ -0,0 +1,844 @@
+#include "xor_smc/Preprocessor.hpp"
+#include "xor_smc/Log.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace xor_smc {
+
+uint64_t Preprocessor::signature(const Literal* lits, uint32_t size) {
+    uint64_t sig = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        sig |= uint64_t(1) << (lits[i].var_id() & 63);
+    }
+    return sig;
+}
+
+bool Preprocessor::run(Formula& formula, const std::vector<uint32_t>& frozen, const PreprocessOptions& options) {
+    ScopedTimer timer(stats_.seconds);
+    options_ = options;
+    ok_ = !formula.has_empty_clause();
+    load(formula, frozen);
+    [[maybe_unused]] const size_t input_units = units_.size();
+
+    if (ok_) {
+        propagate_units();
+    }
+    if (ok_ && options_.substitute) {
+        substitute_all();
+    }
+    if (ok_ && options_.subsume) {
+        subsume_all();
+    }
+    if (ok_ && options_.probe) {
+        probe_all();
+    }
+    if (ok_ && options_.eliminate) {
+        eliminate_all();
+    }
+
+    Formula simplified = unload(formula);
+    XOR_SMC_STAT(stats_.clauses_before += formula.num_clauses());
+    XOR_SMC_STAT(stats_.clauses_after += simplified.num_clauses());
+    XOR_SMC_STAT(stats_.units += units_.size() - input_units);
+    formula = std::move(simplified);
+
+    literals_ = {};
+    clauses_ = {};
+    occurs_ = {};
+    units_ = {};
+    units_head_ = 0;
+    xors_ = {};
+    subsume_queue_ = {};
+    probe_trail_ = {};
+    return ok_;
+}
+
+void Preprocessor::load(const Formula& formula, const std::vector<uint32_t>& frozen) {
+    const uint32_t num_vars = formula.num_variables();
+    values_.assign(num_vars, 0);
+    frozen_.assign(num_vars, 0);
+    touched_.assign(num_vars, 1);
+    marks_.assign(2 * size_t(num_vars), 0);
+    occurs_.assign(2 * size_t(num_vars), {});
+    if (eliminated_.size() < num_vars) {
+        eliminated_.resize(num_vars, 0);
+    }
+    for (uint32_t var : frozen) {
+        if (var < num_vars) {
+            frozen_[var] = 1;
+        }
+    }
+
+    size_t num_literals = 0;
+    for (size_t i = 0; i < formula.num_clauses(); i++) {
+        num_literals += formula.clause(i).size();
+    }
+    literals_.reserve(num_literals);
+    clauses_.reserve(formula.num_clauses());
+    for (size_t i = 0; i < formula.num_clauses() && ok_; i++) {
+        LiteralSpan clause = formula.clause(i);
+        if (clause.size() == 1) {
+            enqueue_unit(clause[0]);
+        } else {
+            add_clause(clause.begin(), clause.size());
+        }
+    }
+    for (const XorConstraint& constraint : formula.xors()) {
+        add_xor(constraint);
+    }
+    mark_xor_variables();
+}
+
+void Preprocessor::add_xor(XorConstraint constraint) {
+    auto& vars = constraint.vars;
+    size_t j = 0;
+    for (uint32_t var : vars) {
+        if (values_[var] != 0) {
+            constraint.rhs ^= values_[var] > 0;
+        } else {
+            vars[j++] = var;
+        }
+    }
+    vars.resize(j);
+    std::sort(vars.begin(), vars.end());
+    j = 0;
+    for (size_t i = 0; i < vars.size(); i++) {
+        if (i + 1 < vars.size() && vars[i] == vars[i + 1]) {
+            i++;
+        } else {
+            vars[j++] = vars[i];
+        }
+    }
+    vars.resize(j);
+
+    if (vars.empty()) {
+        if (constraint.rhs) {
+            ok_ = false;
+        }
+    } else if (vars.size() == 1) {
+        enqueue_unit(Literal(vars[0], constraint.rhs));
+    } else if (vars.size() == 2) {
+        // x ⊕ y = 1 is (x ∨ y)(¬x ∨ ¬y), x ⊕ y = 0 is (x ∨ ¬y)(¬x ∨ y)
+        Literal first[2] = {Literal(vars[0], true), Literal(vars[1], constraint.rhs)};
+        Literal second[2] = {~first[0], ~first[1]};
+        add_clause(first, 2);
+        add_clause(second, 2);
+    } else {
+        xors_.push_back(std::move(constraint));
+    }
+}
+
+void Preprocessor::mark_xor_variables() {
+    in_xor_.assign(values_.size(), 0);
+    for (const XorConstraint& constraint : xors_) {
+        for (uint32_t var : constraint.vars) {
+            in_xor_[var] = 1;
+        }
+    }
+}
+
+Formula Preprocessor::unload(const Formula& formula) const {
+    Formula simplified;
+    simplified.set_num_variables(formula.num_variables());
+    simplified.xors_ = xors_;
+    if (!ok_) {
+        simplified.add_clause(nullptr, 0);
+        return simplified;
+    }
+
+    size_t num_clauses = units_.size();
+    size_t num_literals = units_.size();
+    for (const ClauseInfo& info : clauses_) {
+        if (!info.removed) {
+            num_clauses++;
+            num_literals += info.size;
+        }
+    }
+    simplified.reserve(num_clauses, num_literals);
+    for (const Literal& unit : units_) {
+        simplified.add_clause(&unit, 1);
+    }
+    for (const ClauseInfo& info : clauses_) {
+        if (!info.removed) {
+            simplified.add_clause(literals_.data() + info.start, info.size);
+        }
+    }
+    return simplified;
+}
+
+uint32_t Preprocessor::add_clause(const Literal* lits, uint32_t size) {
+    uint32_t c = clauses_.size();
+    clauses_.push_back({static_cast<uint32_t>(literals_.size()), size, signature(lits, size), false});
+    literals_.insert(literals_.end(), lits, lits + size);
+    for (uint32_t i = 0; i < size; i++) {
+        occurs_[index(lits[i])].push_back(c);
+    }
+    return c;
+}
+
+void Preprocessor::remove_clause(uint32_t c) {
+    // Occurrence lists drop it lazily
+    clauses_[c].removed = true;
+    for (const Literal* lit = begin(c); lit != end(c); lit++) {
+        touched_[lit->var_id()] = 1;
+    }
+}
+
+void Preprocessor::strengthen(uint32_t c, const Literal& lit) {
+    Literal* last = end(c) - 1;
+    Literal* pos = std::find(begin(c), end(c), lit);
+    assert(pos != end(c));
+    *pos = *last;
+    ClauseInfo& info = clauses_[c];
+    info.size--;
+    info.signature = signature(begin(c), info.size);
+    auto& list = occurs_[index(lit)];
+    auto it = std::find(list.begin(), list.end(), c);
+    if (it != list.end()) {
+        list.erase(it);
+    }
+    touched_[lit.var_id()] = 1;
+
+    if (info.size == 1) {
+        // The unit lives on the trail from now on
+        enqueue_unit(*begin(c));
+        remove_clause(c);
+    } else {
+        subsume_queue_.push_back(c);
+    }
+}
+
+const std::vector<uint32_t>& Preprocessor::occurrences(const Literal& lit) {
+    auto& list = occurs_[index(lit)];
+    list.erase(std::remove_if(list.begin(), list.end(), [this](uint32_t c) { return clauses_[c].removed; }),
+               list.end());
+    return list;
+}
+
+void Preprocessor::enqueue_unit(const Literal& lit) {
+    int v = value(lit);
+    if (v < 0) {
+        ok_ = false;
+    } else if (v == 0) {
+        values_[lit.var_id()] = lit.is_positive() ? 1 : -1;
+        units_.push_back(lit);
+    }
+}
+
+bool Preprocessor::propagate_units() {
+    std::vector<uint32_t> falsified;
+    while (ok_ && units_head_ < units_.size()) {
+        const Literal lit = units_[units_head_++];
+        for (uint32_t c : occurs_[index(lit)]) {
+            if (!clauses_[c].removed) {
+                remove_clause(c);
+            }
+        }
+        occurs_[index(lit)] = {};
+        falsified.swap(occurs_[index(~lit)]);
+        for (uint32_t c : falsified) {
+            if (!clauses_[c].removed) {
+                steps_ += clauses_[c].size;
+                strengthen(c, ~lit);
+            }
+        }
+        falsified.clear();
+    }
+    return ok_;
+}
+
+void Preprocessor::subsume_all() {
+    // Smallest clauses first: only they can subsume the larger ones
+    steps_ = 0;
+    subsume_queue_.clear();
+    for (uint32_t c = 0; c < clauses_.size(); c++) {
+        if (!clauses_[c].removed) {
+            subsume_queue_.push_back(c);
+        }
+    }
+    std::stable_sort(subsume_queue_.begin(), subsume_queue_.end(),
+                     [this](uint32_t a, uint32_t b) { return clauses_[a].size > clauses_[b].size; });
+    run_subsumption();
+}
+
+bool Preprocessor::run_subsumption() {
+    while (ok_ && !subsume_queue_.empty() && steps_ < options_.max_steps) {
+        uint32_t c = subsume_queue_.back();
+        subsume_queue_.pop_back();
+        if (!clauses_[c].removed) {
+            backward_subsume(c);
+            propagate_units();
+        }
+    }
+    subsume_queue_.clear();
+    return ok_;
+}
+
+void Preprocessor::backward_subsume(uint32_t c) {
+    const uint32_t size = clauses_[c].size;
+    const uint64_t sig = clauses_[c].signature;
+
+    // Any clause c subsumes or strengthens holds the rarest variable of c
+    Literal best = *begin(c);
+    size_t best_count = SIZE_MAX;
+    for (const Literal* lit = begin(c); lit != end(c); lit++) {
+        size_t count = occurs_[index(*lit)].size() + occurs_[index(~*lit)].size();
+        if (count < best_count) {
+            best = *lit;
+            best_count = count;
+        }
+    }
+
+    for (const Literal* lit = begin(c); lit != end(c); lit++) {
+        marks_[index(*lit)] = 1;
+    }
+    std::vector<std::pair<uint32_t, Literal>> strengthened;
+    for (const Literal& lit : {best, ~best}) {
+        for (uint32_t d : occurrences(lit)) {
+            const ClauseInfo& other = clauses_[d];
+            if (d == c || other.size < size || (sig & ~other.signature)) {
+                continue;
+            }
+            steps_ += other.size;
+            uint32_t matched = 0;
+            uint32_t negated = 0;
+            Literal flipped;
+            for (const Literal* l = begin(d); l != end(d); l++) {
+                if (marks_[index(*l)]) {
+                    matched++;
+                } else if (marks_[index(~*l)]) {
+                    negated++;
+                    flipped = *l;
+                }
+            }
+            if (matched == size) {
+                remove_clause(d);
+                XOR_SMC_STAT(stats_.subsumed++);
+            } else if (negated == 1 && matched + 1 == size) {
+                // c = (¬l ∨ R) and d = (l ∨ R ∨ S) resolve to R ∨ S, which subsumes d
+                strengthened.push_back({d, flipped});
+            }
+        }
+    }
+    for (const Literal* lit = begin(c); lit != end(c); lit++) {
+        marks_[index(*lit)] = 0;
+    }
+
+    for (const auto& [d, lit] : strengthened) {
+        if (!clauses_[d].removed && ok_) {
+            strengthen(d, lit);
+            XOR_SMC_STAT(stats_.strengthened++);
+        }
+    }
+}
+
+bool Preprocessor::subsumed_by_existing(const std::vector<Literal>& lits, uint64_t sig) {
+    for (const Literal& lit : lits) {
+        marks_[index(lit)] = 1;
+    }
+    bool subsumed = false;
+    for (size_t i = 0; i < lits.size() && !subsumed; i++) {
+        for (uint32_t d : occurrences(lits[i])) {
+            const ClauseInfo& other = clauses_[d];
+            if (other.size > lits.size() || (other.signature & ~sig)) {
+                continue;
+            }
+            steps_ += other.size;
+            subsumed = std::all_of(begin(d), end(d), [this](const Literal& l) { return marks_[index(l)]; });
+            if (subsumed) {
+                break;
+            }
+        }
+    }
+    for (const Literal& lit : lits) {
+        marks_[index(lit)] = 0;
+    }
+    return subsumed;
+}
+
+bool Preprocessor::substitute_all() {
+    steps_ = 0;
+    while (ok_ && steps_ < options_.max_steps && substitute_equivalences()) {
+    }
+    return ok_;
+}
+
+bool Preprocessor::substitute_equivalences() {
+    const uint32_t num_vars = values_.size();
+    const uint32_t num_lits = 2 * num_vars;
+    constexpr uint32_t kUnvisited = UINT32_MAX;
+    std::vector<uint32_t> order(num_lits, kUnvisited);
+    std::vector<uint32_t> low(num_lits);
+    std::vector<uint8_t> on_stack(num_lits);
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> component;
+    std::vector<std::pair<uint32_t, size_t>> calls;  // Literal and the next edge to follow
+    std::vector<Literal> replacement(num_vars);
+    std::vector<uint8_t> mapped(num_vars);
+    uint32_t counter = 0;
+
+    // Tarjan's algorithm without recursion. Literal u implies v for each
+    // binary clause (¬u ∨ v), found in the occurrence list of ¬u.
+    auto visit = [&](uint32_t u) {
+        order[u] = low[u] = counter++;
+        stack.push_back(u);
+        on_stack[u] = 1;
+        calls.push_back({u, 0});
+    };
+    for (uint32_t root = 0; root < num_lits && ok_; root++) {
+        if (order[root] != kUnvisited || values_[root >> 1] != 0) {
+            continue;
+        }
+        visit(root);
+        while (!calls.empty() && ok_) {
+            const uint32_t u = calls.back().first;
+            const auto& implications = occurs_[u ^ 1];
+            if (calls.back().second < implications.size()) {
+                uint32_t c = implications[calls.back().second++];
+                if (clauses_[c].removed || clauses_[c].size != 2) {
+                    continue;
+                }
+                steps_ += 2;
+                const Literal* lits = begin(c);
+                uint32_t v = index(lits[0]) == (u ^ 1) ? index(lits[1]) : index(lits[0]);
+                if (order[v] == kUnvisited) {
+                    visit(v);
+                } else if (on_stack[v]) {
+                    low[u] = std::min(low[u], order[v]);
+                }
+                continue;
+            }
+
+            calls.pop_back();
+            if (!calls.empty()) {
+                uint32_t parent = calls.back().first;
+                low[parent] = std::min(low[parent], low[u]);
+            }
+            if (low[u] == order[u]) {
+                component.clear();
+                uint32_t w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = 0;
+                    component.push_back(w);
+                } while (w != u);
+                if (component.size() > 1 && !choose_representative(component, replacement, mapped)) {
+                    ok_ = false;
+                }
+            }
+        }
+    }
+    if (!ok_) {
+        return false;
+    }
+
+    // Free variables leave the formula, taking the value of their
+    // representative in every model; frozen ones stay tied to it
+    std::vector<uint32_t> rewrite;
+    std::vector<uint32_t> tied;
+    bool replaced = false;
+    for (uint32_t var = 0; var < num_vars; var++) {
+        if (!mapped[var] || replacement[var].var_id() == var) {
+            continue;
+        }
+        const Literal x(var, true);
+        for (const Literal& lit : {x, ~x}) {
+            const auto& list = occurrences(lit);
+            rewrite.insert(rewrite.end(), list.begin(), list.end());
+        }
+        if (frozen_[var]) {
+            tied.push_back(var);
+            continue;
+        }
+        const Literal r = replacement[var];
+        extension_.insert(extension_.end(), {~x, r, x, ~r});
+        extension_sizes_.insert(extension_sizes_.end(), {2, 2});
+        eliminated_[var] = 1;
+        replaced = true;
+        XOR_SMC_STAT(stats_.substituted_vars++);
+    }
+    if (!replaced) {
+        return false;
+    }
+
+    auto substitute = [&](const Literal& lit) {
+        if (!mapped[lit.var_id()]) {
+            return lit;
+        }
+        const Literal r = replacement[lit.var_id()];
+        return lit.is_positive() ? r : ~r;
+    };
+    std::sort(rewrite.begin(), rewrite.end());
+    rewrite.erase(std::unique(rewrite.begin(), rewrite.end()), rewrite.end());
+    std::vector<Literal> lits;
+    for (uint32_t c : rewrite) {
+        if (clauses_[c].removed) {
+            continue;
+        }
+        steps_ += clauses_[c].size;
+        lits.clear();
+        bool tautology = false;
+        for (const Literal* lit = begin(c); lit != end(c) && !tautology; lit++) {
+            Literal mapped_lit = substitute(*lit);
+            if (marks_[index(~mapped_lit)]) {
+                tautology = true;
+            } else if (!marks_[index(mapped_lit)]) {
+                marks_[index(mapped_lit)] = 1;
+                lits.push_back(mapped_lit);
+            }
+        }
+        for (const Literal& lit : lits) {
+            marks_[index(lit)] = 0;
+        }
+        remove_clause(c);
+        if (tautology) {
+            continue;
+        }
+        if (lits.size() == 1) {
+            enqueue_unit(lits[0]);
+        } else {
+            add_clause(lits.data(), lits.size());
+        }
+    }
+    for (uint32_t var : tied) {
+        const Literal x(var, true);
+        const Literal r = replacement[var];
+        Literal first[2] = {~x, r};
+        Literal second[2] = {x, ~r};
+        add_clause(first, 2);
+        add_clause(second, 2);
+    }
+
+    // XORs take the representatives too, which may leave some of two
+    // variables or fewer
+    std::vector<XorConstraint> xors;
+    xors.swap(xors_);
+    for (XorConstraint& constraint : xors) {
+        for (uint32_t& var : constraint.vars) {
+            if (mapped[var]) {
+                const Literal r = replacement[var];
+                var = r.var_id();
+                constraint.rhs ^= !r.is_positive();
+            }
+        }
+        add_xor(std::move(constraint));
+    }
+    mark_xor_variables();
+    propagate_units();
+    return ok_;
+}
+
+bool Preprocessor::choose_representative(const std::vector<uint32_t>& component, std::vector<Literal>& replacement,
+                                         std::vector<uint8_t>& mapped) {
+    // Components come in pairs, one the negation of the other; the second
+    // of a pair finds its variables mapped already
+    if (mapped[component[0] >> 1]) {
+        return true;
+    }
+
+    // A frozen variable if there is one, the lowest otherwise
+    for (uint32_t lit : component) {
+        marks_[lit] = 1;
+    }
+    bool consistent = true;
+    Literal rep = literal(component[0]);
+    for (uint32_t lit : component) {
+        consistent &= !marks_[lit ^ 1];
+        const uint32_t var = lit >> 1;
+        if (std::make_pair(!frozen_[var], var) < std::make_pair(!frozen_[rep.var_id()], rep.var_id())) {
+            rep = literal(lit);
+        }
+    }
+    for (uint32_t lit : component) {
+        marks_[lit] = 0;
+    }
+    if (!consistent) {
+        return false;
+    }
+
+    for (uint32_t lit : component) {
+        const Literal member = literal(lit);
+        mapped[member.var_id()] = 1;
+        replacement[member.var_id()] = member.is_positive() ? rep : ~rep;
+    }
+    return true;
+}
+
+bool Preprocessor::probe_all() {
+    // A lone decision only propagates through binary clauses, so only
+    // their variables are probed
+    steps_ = 0;
+    std::vector<uint32_t> candidates;
+    for (uint32_t var = 0; var < values_.size(); var++) {
+        for (const Literal& lit : {Literal(var, true), Literal(var, false)}) {
+            const auto& list = occurrences(lit);
+            if (std::any_of(list.begin(), list.end(), [this](uint32_t c) { return clauses_[c].size == 2; })) {
+                candidates.push_back(var);
+                break;
+            }
+        }
+    }
+
+    std::vector<Literal> implied;
+    std::vector<Literal> both;
+    for (uint32_t var : candidates) {
+        if (steps_ >= options_.max_steps) {
+            break;
+        }
+        if (values_[var] != 0) {
+            continue;
+        }
+        const Literal lit(var, true);
+        bool consistent = probe_propagate(lit);
+        implied.assign(probe_trail_.begin() + 1, probe_trail_.end());
+        undo_probe();
+        if (!consistent) {
+            XOR_SMC_STAT(stats_.failed_literals++);
+            enqueue_unit(~lit);
+            if (!propagate_units()) {
+                return false;
+            }
+            continue;
+        }
+
+        consistent = probe_propagate(~lit);
+        both.clear();
+        if (consistent) {
+            // Implied by x and by ¬x, so true in every model
+            for (const Literal& l : implied) {
+                marks_[index(l)] = 1;
+            }
+            for (size_t i = 1; i < probe_trail_.size(); i++) {
+                if (marks_[index(probe_trail_[i])]) {
+                    both.push_back(probe_trail_[i]);
+                }
+            }
+            for (const Literal& l : implied) {
+                marks_[index(l)] = 0;
+            }
+        }
+        undo_probe();
+        if (!consistent) {
+            XOR_SMC_STAT(stats_.failed_literals++);
+            enqueue_unit(lit);
+        }
+        for (const Literal& l : both) {
+            enqueue_unit(l);
+        }
+        if (!propagate_units()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Preprocessor::probe_propagate(const Literal& lit) {
+    probe_trail_.assign(1, lit);
+    values_[lit.var_id()] = lit.is_positive() ? 1 : -1;
+    for (size_t head = 0; head < probe_trail_.size(); head++) {
+        const Literal false_lit = ~probe_trail_[head];
+        for (uint32_t c : occurrences(false_lit)) {
+            steps_ += clauses_[c].size;
+            uint32_t num_free = 0;
+            Literal free_lit;
+            bool satisfied = false;
+            for (const Literal* l = begin(c); l != end(c) && num_free < 2; l++) {
+                int v = value(*l);
+                if (v > 0) {
+                    satisfied = true;
+                    break;
+                }
+                if (v == 0) {
+                    num_free++;
+                    free_lit = *l;
+                }
+            }
+            if (satisfied || num_free > 1) {
+                continue;
+            }
+            if (num_free == 0) {
+                return false;
+            }
+            values_[free_lit.var_id()] = free_lit.is_positive() ? 1 : -1;
+            probe_trail_.push_back(free_lit);
+        }
+    }
+    return true;
+}
+
+void Preprocessor::undo_probe() {
+    for (const Literal& lit : probe_trail_) {
+        values_[lit.var_id()] = 0;
+    }
+}
+
+bool Preprocessor::eliminate_all() {
+    // Rounds over the variables whose clauses changed, cheapest first,
+    // until a round eliminates nothing
+    steps_ = 0;
+    std::vector<uint32_t> candidates;
+    while (ok_ && steps_ < options_.max_steps) {
+        candidates.clear();
+        for (uint32_t var = 0; var < values_.size(); var++) {
+            if (touched_[var] && !frozen_[var] && !in_xor_[var] && !eliminated_[var] && values_[var] == 0) {
+                candidates.push_back(var);
+            }
+            touched_[var] = 0;
+        }
+        auto cost = [this](uint32_t var) {
+            return uint64_t(occurs_[2 * var].size()) * occurs_[2 * var + 1].size();
+        };
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [&](uint32_t a, uint32_t b) { return cost(a) < cost(b); });
+
+        bool progress = false;
+        for (uint32_t var : candidates) {
+            if (!ok_ || steps_ >= options_.max_steps) {
+                break;
+            }
+            progress |= try_eliminate(var);
+        }
+        if (!progress) {
+            break;
+        }
+    }
+    return ok_;
+}
+
+bool Preprocessor::try_eliminate(uint32_t var) {
+    if (values_[var] != 0 || eliminated_[var]) {
+        return false;
+    }
+    const Literal pos(var, true);
+    const std::vector<uint32_t> pos_clauses = occurrences(pos);
+    const std::vector<uint32_t> neg_clauses = occurrences(~pos);
+    if (pos_clauses.empty() && neg_clauses.empty()) {
+        return false;
+    }
+    if (pos_clauses.size() > options_.max_occurrences && neg_clauses.size() > options_.max_occurrences) {
+        return false;
+    }
+
+    // Every non-tautological resolvent, giving up as soon as a bound breaks
+    const long limit = long(pos_clauses.size() + neg_clauses.size()) + options_.max_growth;
+    std::vector<Literal> resolvent;
+    std::vector<Literal> resolvents;
+    std::vector<uint32_t> resolvent_sizes;
+    for (uint32_t p : pos_clauses) {
+        for (uint32_t n : neg_clauses) {
+            if (!resolve(p, n, var, resolvent)) {
+                continue;
+            }
+            if (resolvent.size() > options_.max_resolvent_size || long(resolvent_sizes.size()) >= limit) {
+                return false;
+            }
+            resolvents.insert(resolvents.end(), resolvent.begin(), resolvent.end());
+            resolvent_sizes.push_back(resolvent.size());
+        }
+    }
+
+    // Only the smaller side needs to be replayed: x gets the value of the
+    // other side's unit unless one of these clauses needs it flipped
+    if (pos_clauses.size() <= neg_clauses.size()) {
+        for (uint32_t p : pos_clauses) {
+            push_extension(p, pos);
+        }
+        extension_.push_back(~pos);
+    } else {
+        for (uint32_t n : neg_clauses) {
+            push_extension(n, ~pos);
+        }
+        extension_.push_back(pos);
+    }
+    extension_sizes_.push_back(1);
+    for (uint32_t c : pos_clauses) {
+        remove_clause(c);
+    }
+    for (uint32_t c : neg_clauses) {
+        remove_clause(c);
+    }
+    eliminated_[var] = 1;
+    XOR_SMC_STAT(stats_.eliminated_vars++);
+
+    size_t offset = 0;
+    for (uint32_t size : resolvent_sizes) {
+        resolvent.assign(resolvents.begin() + offset, resolvents.begin() + offset + size);
+        offset += size;
+        if (resolvent.size() == 1) {
+            enqueue_unit(resolvent[0]);
+            continue;
+        }
+        if (subsumed_by_existing(resolvent, signature(resolvent.data(), size))) {
+            continue;
+        }
+        uint32_t c = add_clause(resolvent.data(), size);
+        subsume_queue_.push_back(c);
+        for (const Literal& lit : resolvent) {
+            touched_[lit.var_id()] = 1;
+        }
+        XOR_SMC_STAT(stats_.resolvents++);
+    }
+    if (propagate_units() && options_.subsume) {
+        run_subsumption();
+    }
+    subsume_queue_.clear();
+    return true;
+}
+
+bool Preprocessor::resolve(uint32_t p, uint32_t n, uint32_t var, std::vector<Literal>& resolvent) {
+    steps_ += clauses_[p].size + clauses_[n].size;
+    resolvent.clear();
+    for (const Literal* lit = begin(p); lit != end(p); lit++) {
+        if (lit->var_id() != var) {
+            marks_[index(*lit)] = 1;
+            resolvent.push_back(*lit);
+        }
+    }
+    bool tautology = false;
+    for (const Literal* lit = begin(n); lit != end(n); lit++) {
+        if (lit->var_id() == var || marks_[index(*lit)]) {
+            continue;
+        }
+        if (marks_[index(~*lit)]) {
+            tautology = true;
+            break;
+        }
+        resolvent.push_back(*lit);
+    }
+    for (const Literal* lit = begin(p); lit != end(p); lit++) {
+        marks_[index(*lit)] = 0;
+    }
+    return !tautology;
+}
+
+void Preprocessor::push_extension(uint32_t c, const Literal& pivot) {
+    extension_.push_back(pivot);
+    for (const Literal* lit = begin(c); lit != end(c); lit++) {
+        if (*lit != pivot) {
+            extension_.push_back(*lit);
+        }
+    }
+    extension_sizes_.push_back(clauses_[c].size);
+}
+
+void Preprocessor::extend_model(std::vector<bool>& model) const {
+    // Latest elimination first: a clause saved when its pivot went only
+    // mentions variables still present then, which are eliminated later
+    // if at all, so they already have their final values
+    size_t end = extension_.size();
+    for (size_t i = extension_sizes_.size(); i-- > 0;) {
+        size_t start = end - extension_sizes_[i];
+        bool satisfied = false;
+        for (size_t j = start; j < end && !satisfied; j++) {
+            assert(extension_[j].var_id() < model.size());
+            satisfied = model[extension_[j].var_id()] == extension_[j].is_positive();
+        }
+        if (!satisfied) {
+            model[extension_[start].var_id()] = extension_[start].is_positive();
+        }
+        end = start;
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+#include "xor_smc/Restart.hpp"
+
+namespace xor_smc {
+
+LubyRestart::LubyRestart(uint64_t unit)
+    : unit_(unit), restarts_(0), conflicts_(0), limit_(unit) {}
+
+double LubyRestart::luby(double y, uint64_t x) {
+    // Find the finite subsequence that contains index x and its size
+    uint64_t size = 1;
+    int seq = 0;
+    while (size < x + 1) {
+        seq++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != x) {
+        size = (size - 1) >> 1;
+        seq--;
+        x = x % size;
+    }
+
+    double result = 1;
+    for (int i = 0; i < seq; i++) {
+        result *= y;
+    }
+    return result;
+}
+
+void LubyRestart::on_conflict(uint32_t, size_t) {
+    conflicts_++;
+}
+
+bool LubyRestart::should_restart() const {
+    return conflicts_ >= limit_;
+}
+
+void LubyRestart::on_restart() {
+    restarts_++;
+    conflicts_ = 0;
+    limit_ = static_cast<uint64_t>(unit_ * luby(2, restarts_));
+}
+
+GlucoseRestart::GlucoseRestart(double margin, double block_margin,
+                               uint64_t min_conflicts, uint64_t block_after)
+    : margin_(margin), block_margin_(block_margin),
+      min_conflicts_(min_conflicts), block_after_(block_after),
+      fast_lbd_(1.0 / 32), slow_lbd_(1.0 / 100000), trail_(1.0 / 5000),
+      conflicts_(0), conflicts_since_restart_(0) {}
+
+void GlucoseRestart::on_conflict(uint32_t lbd, size_t trail_size) {
+    conflicts_++;
+    conflicts_since_restart_++;
+
+    // Blocking: a trail much longer than usual postpones the next restart
+    if (conflicts_ > block_after_ &&
+        conflicts_since_restart_ >= min_conflicts_ &&
+        trail_size > block_margin_ * trail_.value()) {
+        conflicts_since_restart_ = 0;
+    }
+    trail_.update(trail_size);
+
+    fast_lbd_.update(lbd);
+    slow_lbd_.update(lbd);
+}
+
+bool GlucoseRestart::should_restart() const {
+    return conflicts_since_restart_ >= min_conflicts_ &&
+           fast_lbd_.value() > margin_ * slow_lbd_.value();
+}
+
+void GlucoseRestart::on_restart() {
+    conflicts_since_restart_ = 0;
+}
+
+}
@@ -0,0 +1,605 @@
+#include "xor_smc/Solver.hpp"
+#include "xor_smc/Log.hpp"
+#include "xor_smc/ThreadPool.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace xor_smc {
+
+namespace {
+
+// Each trial gets its own stream, fixed by the master seed and the trial's
+// position alone, so the hashes do not depend on scheduling
+uint64_t trial_seed(uint64_t master, size_t threshold, int trial) {
+    return splitmix64(splitmix64(master ^ splitmix64(threshold)) + trial);
+}
+
+// Sorted union of the variable sets
+std::vector<uint32_t> all_variables(const std::vector<std::vector<uint32_t>>& sets) {
+    std::vector<uint32_t> vars;
+    for (const auto& set : sets) {
+        vars.insert(vars.end(), set.begin(), set.end());
+    }
+    std::sort(vars.begin(), vars.end());
+    vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+    return vars;
+}
+
+int num_hash_constraints(uint32_t threshold) {
+    return threshold <= 1 ? 0 : std::ceil(std::log2(threshold));
+}
+
+// Sequential majority vote of one threshold. Outcomes are consumed in
+// trial order, so the verdict only depends on the trials' results and
+// never on which worker finished first.
+class Vote {
+public:
+    void init(int budget, int margin) {
+        budget_ = budget;
+        margin_ = margin;
+        outcomes_.assign(budget, kPending);
+    }
+
+    // Records the outcome of a trial; returns true once the vote is decided
+    bool record(int trial, bool is_sat) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outcomes_[trial] = is_sat;
+        while (!decided_ && next_ < budget_ && outcomes_[next_] != kPending) {
+            if (outcomes_[next_++]) {
+                successes_++;
+            } else {
+                failures_++;
+            }
+            if (successes_ > budget_ / 2 || successes_ - failures_ >= margin_) {
+                decided_ = true;
+                passed_ = true;
+            } else if (failures_ >= budget_ - budget_ / 2 || failures_ - successes_ >= margin_) {
+                decided_ = true;
+            }
+        }
+        if (decided_) {
+            stop = true;
+        }
+        return decided_;
+    }
+
+    bool decided() const { return decided_.load(); }
+    bool passed() const { return passed_; }
+    int successes() const { return successes_; }
+    int failures() const { return failures_; }
+
+    // Set once no more trials are needed; running ones are interrupted
+    std::atomic<bool> stop{false};
+
+private:
+    static constexpr int8_t kPending = -1;
+
+    std::mutex mutex_;
+    std::vector<int8_t> outcomes_;
+    int budget_ = 0;
+    int margin_ = 0;
+    int next_ = 0;  // Outcomes before this trial are counted
+    int successes_ = 0;
+    int failures_ = 0;
+    std::atomic<bool> decided_{false};
+    bool passed_ = false;
+};
+
+// Trials finish in any order on the workers
+void record_trial(SmcThresholdStats& stats, std::mutex& mutex, int trial, bool is_sat,
+                  double seconds, const SolverStats& solver) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.trials.push_back({trial, is_sat, seconds, solver.decisions, solver.conflicts, solver.propagations});
+    stats.solver += solver;
+}
+
+void finish_threshold_stats(SmcThresholdStats& stats, uint32_t threshold, const Vote& vote) {
+    std::sort(stats.trials.begin(), stats.trials.end(),
+              [](const SmcTrialStats& a, const SmcTrialStats& b) { return a.trial < b.trial; });
+    stats.threshold = threshold;
+    stats.num_xors = num_hash_constraints(threshold);
+    stats.successes = vote.successes();
+    stats.failures = vote.failures();
+    stats.decided = vote.decided();
+    stats.passed = vote.passed();
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// At least k of lits are true, by a sequential counter (Sinz, CP 2005)
+// kept in one direction only: at_least[c] can only be true if c + 1 of
+// the literals seen so far are
+void add_at_least(Solver& solver, const std::vector<Literal>& lits, size_t k) {
+    if (k == 0) {
+        return;
+    }
+    if (k > lits.size()) {
+        solver.add_clause(std::vector<Literal>{});
+        return;
+    }
+    std::vector<uint32_t> prev;
+    for (size_t j = 0; j < lits.size(); j++) {
+        std::vector<uint32_t> at_least(std::min(j + 1, k));
+        for (size_t c = 0; c < at_least.size(); c++) {
+            at_least[c] = solver.new_var();
+            // c + 1 among the first j + 1: c + 1 among the first j, or
+            // lits[j] and c among the first j
+            std::vector<Literal> with_lit{Literal(at_least[c], false), lits[j]};
+            std::vector<Literal> with_prev{Literal(at_least[c], false)};
+            if (c < prev.size()) {
+                with_lit.push_back(Literal(prev[c], true));
+                with_prev.push_back(Literal(prev[c], true));
+            }
+            solver.add_clause(with_lit);
+            if (c > 0) {
+                with_prev.push_back(Literal(prev[c - 1], true));
+                solver.add_clause(with_prev);
+            }
+        }
+        prev = std::move(at_least);
+    }
+    solver.add_clause({Literal(prev[k - 1], true)});
+}
+
+}
+
+// Number of trials after which a plain majority is wrong with probability
+// at most 1 - confidence (Hoeffding), rounded up to an odd count
+int smc_trial_budget(const SmcOptions& options) {
+    int budget = std::max(options.num_xor_tries, 1);
+    if (options.confidence > 0.5 && options.confidence < 1.0) {
+        double trials = std::log(1.0 / (1.0 - options.confidence)) /
+                        (2.0 * options.bias * options.bias);
+        budget = std::max(budget, static_cast<int>(std::ceil(trials)));
+    }
+    return budget | 1;
+}
+
+// Wald's test of p = 1/2 + bias against p = 1/2 - bias with both error
+// rates at 1 - confidence: every trial moves the log-likelihood ratio by
+// ln((1/2 + bias) / (1/2 - bias)) either way, so the test stops once
+// successes and failures differ by this margin
+int smc_vote_margin(const SmcOptions& options) {
+    if (!(options.confidence > 0.5 && options.confidence < 1.0) ||
+        !(options.bias > 0.0 && options.bias < 0.5)) {
+        return std::numeric_limits<int>::max();
+    }
+    double step = std::log((0.5 + options.bias) / (0.5 - options.bias));
+    double bound = std::log(options.confidence / (1.0 - options.confidence));
+    return static_cast<int>(std::ceil(bound / step));
+}
+
+bool Solver::solve_smc(
+    const std::vector<uint32_t>& thresholds,
+    const std::vector<std::vector<uint32_t>>& counting_variables,
+    const std::vector<std::vector<uint32_t>>& fixed_variables,
+    int num_xor_tries,
+    double confidence
+) {
+    SmcOptions options;
+    options.num_xor_tries = num_xor_tries;
+    options.confidence = confidence;
+    return solve_smc(thresholds, counting_variables, fixed_variables, options);
+}
+
+bool Solver::solve_smc(
+    const std::vector<uint32_t>& thresholds,
+    const std::vector<std::vector<uint32_t>>& counting_variables,
+    const std::vector<std::vector<uint32_t>>& fixed_variables,
+    const SmcOptions& options
+) {
+    smc_witness_.clear();
+    for (const auto& fixed : fixed_variables) {
+        if (!fixed.empty()) {
+            return solve_smc_joint(thresholds, counting_variables, fixed_variables, options);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const int budget = smc_trial_budget(options);
+    const int margin = smc_vote_margin(options);
+
+    unsigned num_threads = options.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<Vote> votes(thresholds.size());
+    for (Vote& vote : votes) {
+        vote.init(budget, margin);
+    }
+    std::atomic<bool> failed{false};
+    smc_stats_ = SmcStats();
+    smc_stats_.thresholds.resize(thresholds.size());
+    std::mutex stats_mutex;
+
+    // One solver per worker serves all of its trials: each trial's XORs
+    // live in a group released afterwards, so clauses learnt from the base
+    // formula carry over. Each worker's solver copies one snapshot,
+    // simplified once for all of them.
+    const Formula base = options.preprocess
+                             ? simplified_snapshot(all_variables(counting_variables), smc_stats_.preprocess)
+                             : snapshot();
+    std::vector<std::unique_ptr<Solver>> trial_solvers(num_threads);
+
+    auto run_trial = [&](unsigned worker, size_t i, int trial) {
+        Vote& vote = votes[i];
+        if (vote.stop.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto& solver = trial_solvers[worker];
+        if (!solver) {
+            solver = std::make_unique<Solver>();
+            copy_problem_to(*solver, base);
+        }
+
+        std::mt19937_64 rng(trial_seed(seed_, i, trial));
+        auto hash = draw_hash(options.hash, counting_variables[i], num_hash_constraints(thresholds[i]),
+                              options.sparse_density, rng);
+
+        solver->interrupt_ = &vote.stop;
+        solver->reset_stats();
+        auto trial_start = std::chrono::steady_clock::now();
+        bool is_sat = solver->run_smc_trial(hash);
+        if (solver->interrupted_) {
+            return;
+        }
+        record_trial(smc_stats_.thresholds[i], stats_mutex, trial, is_sat, seconds_since(trial_start),
+                     solver->stats());
+
+        if (vote.record(trial, is_sat) && !vote.passed()) {
+            // One failed threshold answers the whole query
+            failed = true;
+            for (Vote& other : votes) {
+                other.stop = true;
+            }
+        }
+    };
+
+    for (size_t i = 0; i < thresholds.size(); i++) {
+        XOR_SMC_INFO("Testing threshold " << thresholds[i] << " using "
+                     << num_hash_constraints(thresholds[i]) << " XORs, at most "
+                     << budget << " trials");
+    }
+
+    if (num_threads == 1) {
+        for (size_t i = 0; i < thresholds.size() && !failed; i++) {
+            for (int trial = 0; trial < budget && !votes[i].stop; trial++) {
+                run_trial(0, i, trial);
+            }
+        }
+    } else {
+        // Votes count outcomes in trial order, so each task claims the next
+        // trial when it starts rather than a fixed one: a worker that is
+        // slow to start cannot hold the first trials back in its deque
+        ThreadPool pool(num_threads);
+        std::vector<std::atomic<int>> next_trial(thresholds.size());
+        for (size_t i = 0; i < thresholds.size(); i++) {
+            for (int trial = 0; trial < budget; trial++) {
+                pool.submit([&run_trial, &next_trial, i](unsigned worker) { run_trial(worker, i, next_trial[i]++); });
+            }
+        }
+        pool.wait();
+    }
+
+    for (size_t i = 0; i < thresholds.size(); i++) {
+        finish_threshold_stats(smc_stats_.thresholds[i], thresholds[i], votes[i]);
+        smc_stats_.solver += smc_stats_.thresholds[i].solver;
+        if (!votes[i].decided()) {
+            continue;
+        }
+        XOR_SMC_INFO("Threshold " << thresholds[i] << (votes[i].passed() ? " passed" : " failed")
+                     << " after " << votes[i].successes() + votes[i].failures() << " trials ("
+                     << votes[i].successes() << " SAT, " << votes[i].failures() << " UNSAT)");
+    }
+    smc_stats_.seconds = seconds_since(start);
+
+    return !failed;
+}
+
+bool Solver::solve_smc_joint(
+    const std::vector<uint32_t>& thresholds,
+    const std::vector<std::vector<uint32_t>>& counting_variables,
+    const std::vector<std::vector<uint32_t>>& fixed_variables,
+    const SmcOptions& options
+) {
+    // Every trial is a full copy of the problem, so the joint formula is
+    // about copies * |F| per threshold: it takes num_xor_tries copies, made
+    // odd, rather than the larger budget derived from the confidence
+    const auto start = std::chrono::steady_clock::now();
+    const int budget = std::max(options.num_xor_tries, 1) | 1;
+    const uint32_t num_vars = num_variables();
+    smc_stats_ = SmcStats();
+    smc_stats_.thresholds.resize(thresholds.size());
+
+    // The original variables stand for the fixed ones; every copy renames
+    // the rest to fresh variables
+    Solver joint;
+    joint.set_num_variables(num_vars);
+    joint.native_xor_ = native_xor_;
+    joint.xor_chunk_width_ = xor_chunk_width_;
+
+    // Every copy is taken from the simplified problem
+    std::vector<uint32_t> fixed = all_variables(fixed_variables);
+    Solver simplified;
+    const Solver* source = this;
+    if (options.preprocess) {
+        std::vector<uint32_t> kept = all_variables(counting_variables);
+        kept.insert(kept.end(), fixed.begin(), fixed.end());
+        copy_problem_to(simplified, simplified_snapshot(kept, smc_stats_.preprocess));
+        source = &simplified;
+    }
+
+    std::vector<uint32_t> var_map(num_vars);
+    std::vector<uint8_t> shared(num_vars);
+    for (size_t i = 0; i < thresholds.size(); i++) {
+        std::fill(shared.begin(), shared.end(), 0);
+        for (uint32_t var : fixed_variables[i]) {
+            assert(var < num_vars);
+            shared[var] = 1;
+        }
+
+        // Without XORs every copy would be the same formula
+        int num_xors = num_hash_constraints(thresholds[i]);
+        int copies = num_xors == 0 ? 1 : budget;
+        XOR_SMC_INFO("Threshold " << thresholds[i] << ": " << copies << " copies with "
+                     << num_xors << " XORs each");
+
+        std::vector<Literal> selected;
+        for (int trial = 0; trial < copies; trial++) {
+            for (uint32_t var = 0; var < num_vars; var++) {
+                var_map[var] = shared[var] ? var : joint.new_var();
+            }
+            uint32_t selector = joint.new_var();
+            source->copy_guarded_to(joint, var_map, selector);
+
+            // Same stream as the trial of the independent vote
+            std::vector<uint32_t> counted;
+            for (uint32_t var : counting_variables[i]) {
+                counted.push_back(var_map[var]);
+            }
+            std::mt19937_64 rng(trial_seed(seed_, i, trial));
+            for (const auto& row : draw_hash(options.hash, counted, num_xors, options.sparse_density, rng)) {
+                uint32_t guard = joint.new_var();
+                std::vector<Literal> xor_lits;
+                for (uint32_t var : row.vars) {
+                    xor_lits.push_back(Literal(var, true));
+                }
+                xor_lits.push_back(Literal(guard, row.rhs));
+                joint.add_xor(xor_lits);
+                joint.add_clause({Literal(guard, false), Literal(selector, false)});
+            }
+            selected.push_back(Literal(selector, true));
+        }
+        add_at_least(joint, selected, copies / 2 + 1);
+        smc_stats_.thresholds[i].threshold = thresholds[i];
+        smc_stats_.thresholds[i].num_xors = num_xors;
+    }
+
+    XOR_SMC_INFO("Joint formula: " << joint.num_variables() << " variables, "
+                 << joint.num_clauses() << " clauses");
+    bool sat = joint.solve();
+    // One solve decides every threshold at once; there are no trials
+    for (SmcThresholdStats& stats : smc_stats_.thresholds) {
+        stats.decided = true;
+        stats.passed = sat;
+    }
+    smc_stats_.solver = joint.stats();
+    smc_stats_.seconds = seconds_since(start);
+    if (!sat) {
+        XOR_SMC_INFO("No assignment to the fixed variables meets every threshold");
+        return false;
+    }
+
+    for (uint32_t var : fixed) {
+        smc_witness_.push_back(Literal(var, joint.get_value(var)));
+    }
+    XOR_SMC_INFO("Found an assignment to " << fixed.size() << " fixed variables meeting every threshold");
+    return true;
+}
+
+std::vector<bool> Solver::solve_smc_sweep(
+    const std::vector<uint32_t>& thresholds,
+    const std::vector<std::vector<uint32_t>>& counting_variables,
+    const SmcOptions& options
+) {
+    const auto start = std::chrono::steady_clock::now();
+    const int budget = smc_trial_budget(options);
+    const int margin = smc_vote_margin(options);
+
+    unsigned num_threads = options.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Thresholds on the same counting set, by increasing XOR count
+    std::vector<std::vector<size_t>> sets;
+    std::map<std::vector<uint32_t>, size_t> set_of;
+    for (size_t i = 0; i < thresholds.size(); i++) {
+        auto it = set_of.emplace(counting_variables[i], sets.size()).first;
+        if (it->second == sets.size()) {
+            sets.emplace_back();
+        }
+        sets[it->second].push_back(i);
+    }
+    for (auto& members : sets) {
+        std::stable_sort(members.begin(), members.end(), [&](size_t a, size_t b) {
+            return thresholds[a] < thresholds[b];
+        });
+    }
+
+    std::vector<Vote> votes(thresholds.size());
+    for (Vote& vote : votes) {
+        vote.init(budget, margin);
+    }
+    std::vector<std::atomic<bool>> set_stop(sets.size());  // Every vote of the set is decided
+    smc_stats_ = SmcStats();
+    smc_stats_.thresholds.resize(thresholds.size());
+    std::mutex stats_mutex;
+
+    const Formula base = options.preprocess
+                             ? simplified_snapshot(all_variables(counting_variables), smc_stats_.preprocess)
+                             : snapshot();
+    std::vector<std::unique_ptr<Solver>> trial_solvers(num_threads);
+
+    auto run_trial = [&](unsigned worker, size_t set, int trial) {
+        std::atomic<bool>& stop = set_stop[set];
+        if (stop.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Only thresholds still being voted on need this trial's outcome
+        std::vector<size_t> open;
+        std::vector<int> num_xors;
+        for (size_t i : sets[set]) {
+            if (!votes[i].decided()) {
+                open.push_back(i);
+                num_xors.push_back(num_hash_constraints(thresholds[i]));
+            }
+        }
+        if (open.empty()) {
+            stop = true;
+            return;
+        }
+
+        auto& solver = trial_solvers[worker];
+        if (!solver) {
+            solver = std::make_unique<Solver>();
+            copy_problem_to(*solver, base);
+        }
+
+        // Drawn for the largest threshold, so the hash does not depend on
+        // which thresholds are still open
+        const auto& vars = counting_variables[sets[set].front()];
+        std::mt19937_64 rng(trial_seed(seed_, set, trial));
+        auto rows = draw_hash(options.hash, vars, num_hash_constraints(thresholds[sets[set].back()]),
+                              options.sparse_density, rng);
+
+        solver->interrupt_ = &stop;
+        solver->reset_stats();
+        auto trial_start = std::chrono::steady_clock::now();
+        size_t num_sat = solver->run_sweep_trial(rows, num_xors);
+        if (solver->interrupted_) {
+            return;
+        }
+        const double seconds = seconds_since(trial_start);
+        const SolverStats solver_stats = solver->stats();
+        for (size_t k = 0; k < open.size(); k++) {
+            record_trial(smc_stats_.thresholds[open[k]], stats_mutex, trial, k < num_sat, seconds, solver_stats);
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            smc_stats_.solver += solver_stats;
+        }
+
+        bool all_decided = true;
+        for (size_t k = 0; k < open.size(); k++) {
+            all_decided &= votes[open[k]].record(trial, k < num_sat);
+        }
+        if (all_decided) {
+            stop = true;
+        }
+    };
+
+    if (num_threads == 1) {
+        for (size_t set = 0; set < sets.size(); set++) {
+            for (int trial = 0; trial < budget && !set_stop[set]; trial++) {
+                run_trial(0, set, trial);
+            }
+        }
+    } else {
+        // Trials claimed in order, as in solve_smc
+        ThreadPool pool(num_threads);
+        std::vector<std::atomic<int>> next_trial(sets.size());
+        for (size_t set = 0; set < sets.size(); set++) {
+            for (int trial = 0; trial < budget; trial++) {
+                pool.submit([&run_trial, &next_trial, set](unsigned worker) {
+                    run_trial(worker, set, next_trial[set]++);
+                });
+            }
+        }
+        pool.wait();
+    }
+
+    std::vector<bool> verdicts(thresholds.size());
+    for (size_t i = 0; i < thresholds.size(); i++) {
+        verdicts[i] = votes[i].passed();
+        finish_threshold_stats(smc_stats_.thresholds[i], thresholds[i], votes[i]);
+        XOR_SMC_INFO("Threshold " << thresholds[i] << (verdicts[i] ? " passed" : " failed")
+                     << " after " << votes[i].successes() + votes[i].failures() << " trials ("
+                     << votes[i].successes() << " SAT, " << votes[i].failures() << " UNSAT)");
+    }
+    smc_stats_.seconds = seconds_since(start);
+    return verdicts;
+}
+
+void Solver::add_hash_row(const XorConstraint& row, uint32_t group) {
+    // XOR of the literals is true, so a negative one encodes rhs = 0
+    std::vector<Literal> xor_lits;
+    for (uint32_t var : row.vars) {
+        xor_lits.push_back(Literal(var, true));
+    }
+    if (!row.rhs) {
+        if (xor_lits.empty()) {
+            return;
+        }
+        xor_lits[0] = ~xor_lits[0];
+    }
+    add_xor(xor_lits, group);
+}
+
+bool Solver::run_smc_trial(const std::vector<XorConstraint>& hash) {
+    uint32_t group = new_group();
+    for (const auto& row : hash) {
+        add_hash_row(row, group);
+    }
+
+    bool is_sat = solve();
+    release_group(group);
+    return is_sat;
+}
+
+size_t Solver::run_sweep_trial(const std::vector<XorConstraint>& rows, const std::vector<int>& num_xors) {
+    // With rows[0..q) enforced for q XORs, SAT is monotone in q: bisect
+    // for the first of the sorted XOR counts that is UNSAT
+    std::vector<uint32_t> row_groups;
+    size_t lo = 0;
+    size_t hi = num_xors.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t q = num_xors[mid];
+        while (row_groups.size() < q) {
+            row_groups.push_back(new_group());
+            add_hash_row(rows[row_groups.size() - 1], row_groups.back());
+        }
+        for (size_t i = 0; i < row_groups.size(); i++) {
+            set_group_enabled(row_groups[i], i < q);
+        }
+
+        bool is_sat = solve();
+        if (interrupted_) {
+            break;
+        }
+        if (is_sat) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (uint32_t group : row_groups) {
+        release_group(group);
+    }
+    return lo;
+}
+
+}
@@ -1,425 +1,1399 @@
 #include "xor_smc/Solver.hpp"
-#include <iostream>
+#include "xor_smc/Log.hpp"
 #include <cassert>
-#include <queue>
-#include <unordered_set>
 #include <algorithm>
-#include <cmath>
+#include <random>
 
 namespace xor_smc {
 
-Solver::Solver() : decision_level_(0), rng_(std::random_device{}()) {
-    std::cout << "Creating Solver...\n";
+Solver::ClauseRef Solver::ClauseAllocator::alloc(
+    const Literal* lits, uint32_t size, bool learnt, bool xor_reason) {
+    ClauseRef ref = memory_.size();
+    memory_.resize(memory_.size() + kHeaderWords + size + learnt);
+
+    Clause& clause = (*this)[ref];
+    clause.size_ = size;
+    clause.flags_ = (learnt ? Clause::kLearnt : 0) | (xor_reason ? Clause::kXorReason : 0);
+    std::copy(lits, lits + size, clause.begin());
+    if (learnt) {
+        clause.activity() = 0;
+    }
+    return ref;
+}
+
+Solver::ClauseRef Solver::ClauseAllocator::adopt(std::vector<uint32_t>&& words) {
+    ClauseRef ref = memory_.size();
+    if (memory_.empty()) {
+        memory_ = std::move(words);
+    } else {
+        memory_.insert(memory_.end(), words.begin(), words.end());
+    }
+    return ref;
+}
+
+void Solver::ClauseAllocator::free(ClauseRef ref) {
+    Clause& clause = (*this)[ref];
+    clause.flags_ |= Clause::kRemoved;
+    wasted_ += kHeaderWords + clause.size() + clause.learnt();
+}
+
+void Solver::ClauseAllocator::reloc(ClauseRef& ref, ClauseAllocator& to) {
+    Clause& clause = (*this)[ref];
+    uint32_t* forward = reinterpret_cast<uint32_t*>(clause.begin());
+    if (clause.reloced()) {
+        // The new location is kept in place of the first literal
+        ref = *forward;
+        return;
+    }
+
+    ClauseRef moved = to.alloc(clause.begin(), clause.size(), clause.learnt(), clause.is_xor_reason());
+    to[moved].flags_ = clause.flags_;
+    if (clause.learnt()) {
+        to[moved].activity() = clause.activity();
+    }
+
+    clause.flags_ |= Clause::kReloced;
+    *forward = moved;
+    ref = moved;
+}
+
+Solver::Solver()
+    : num_binary_(0), qhead_(0), bin_qhead_(0), conflict_clause_(kNoClause), ok_(true),
+      decision_level_(0), var_inc_(1.0), var_decay_(0.95),
+      restart_policy_(std::make_unique<GlucoseRestart>()), lbd_stamp_(0),
+      clause_inc_(1.0), clause_decay_(0.999), num_conflicts_(0),
+      next_reduce_(2000), reduce_interval_(2000), native_xor_(true), xor_chunk_width_(4),
+      xor_qhead_(0),
+      seed_((uint64_t(std::random_device{}()) << 32) | std::random_device{}()),
+      interrupt_(nullptr), interrupted_(false) {
+    XOR_SMC_DEBUG("Creating solver");
+}
+
+Solver::Solver(Formula formula) : Solver() {
+    add_formula(std::move(formula));
 }
 
 void Solver::set_num_variables(uint32_t num_vars) {
-    std::cout << "Setting number of variables to " << num_vars << "\n";
-    assignments_.resize(num_vars, {-1, false, nullptr});
+    XOR_SMC_DEBUG("Setting number of variables to " << num_vars);
+    grow_variables(num_vars);
+}
+
+uint32_t Solver::new_var() {
+    uint32_t var = num_variables();
+    grow_variables(var + 1);
+    return var;
+}
+
+void Solver::grow_variables(uint32_t num_vars) {
+    uint32_t old_vars = assignments_.size();
+    if (num_vars <= old_vars) {
+        return;
+    }
+    assignments_.resize(num_vars, {-1, false, kNoClause});
     watches_.resize(num_vars * 2);  // Two watch lists per variable (pos/neg)
+    binary_watches_.resize(num_vars * 2);
     trail_.reserve(num_vars);
-    seen_.resize(num_vars, false);
+    seen_.resize(num_vars, 0);
+    activity_.resize(num_vars, 0.0);
+    polarity_.resize(num_vars, true);
+    is_internal_.resize(num_vars, 0);
+    level_stamp_.resize(num_vars + 1, 0);
+    order_heap_.grow(num_vars);
+    for (uint32_t var = old_vars; var < num_vars; var++) {
+        order_heap_.insert(var, activity_);
+    }
+}
+
+void Solver::set_restart_policy(std::unique_ptr<RestartPolicy> policy) {
+    restart_policy_ = std::move(policy);
 }
 
 void Solver::add_clause(const std::vector<Literal>& literals) {
-    if (literals.empty()) {
-        std::cout << "Adding empty clause - formula is UNSAT\n";
-        clauses_.push_back(std::make_shared<Clause>(literals));
+    add_clause(literals.data(), literals.size());
+}
+
+void Solver::add_clause(std::initializer_list<Literal> literals) {
+    add_clause(literals.begin(), literals.size());
+}
+
+void Solver::add_clause(const Literal* literals, size_t size) {
+    ClauseRef cref = store_clause(literals, size);
+    if (cref != kNoClause) {
+        attach_watches(cref);
+        clauses_.push_back(cref);
+    }
+}
+
+void Solver::add_clauses(const Literal* literals, const size_t* offsets, size_t num_clauses) {
+    if (num_clauses == 0) {
         return;
     }
+    ca_.reserve(ca_.size() + num_clauses * ClauseAllocator::kHeaderWords +
+                (offsets[num_clauses] - offsets[0]));
+    size_t first = clauses_.size();
+    for (size_t i = 0; i < num_clauses; i++) {
+        ClauseRef cref = store_clause(literals + offsets[i], offsets[i + 1] - offsets[i]);
+        if (cref != kNoClause) {
+            clauses_.push_back(cref);
+        }
+    }
+    attach_originals(first);
+}
 
-    auto clause = std::make_shared<Clause>(literals);
-    
-    // For unit clauses, try to assign immediately
-    if (literals.size() == 1) {
-        uint32_t var = literals[0].var_id();
-        if (assignments_[var].level == -1) {
-            assign(var, literals[0].is_positive(), 0, clause);
-        } else if (assignments_[var].value != literals[0].is_positive()) {
-            // Contradiction
-            clauses_.push_back(std::make_shared<Clause>(std::vector<Literal>()));
-            return;
+Solver::ClauseRef Solver::store_clause(const Literal* literals, size_t size) {
+    if (size == 0) {
+        XOR_SMC_DEBUG("Adding empty clause - formula is UNSAT");
+        ok_ = false;
+        return kNoClause;
+    }
+    if (!ok_) {
+        return kNoClause;
+    }
+    backtrack(0);
+
+    // Simplify against level 0: duplicates and false literals go,
+    // satisfied and tautological clauses are not stored at all
+    add_buffer_.assign(literals, literals + size);
+    std::sort(add_buffer_.begin(), add_buffer_.end(), [](const Literal& a, const Literal& b) {
+        return watch_index(a) < watch_index(b);
+    });
+    size_t j = 0;
+    for (size_t i = 0; i < add_buffer_.size(); i++) {
+        const Literal& lit = add_buffer_[i];
+        assert(lit.var_id() < assignments_.size());  // Declared with set_num_variables or new_var
+        assert(!preprocessor_.is_eliminated(lit.var_id()));
+        if (is_true(lit) || (j > 0 && add_buffer_[j - 1] == ~lit)) {
+            return kNoClause;
         }
+        if (!is_false(lit) && (j == 0 || add_buffer_[j - 1] != lit)) {
+            add_buffer_[j++] = lit;
+        }
+    }
+    add_buffer_.resize(j);
+
+    if (add_buffer_.empty()) {
+        ok_ = false;
+        return kNoClause;
+    }
+
+    // Units are assigned at level 0 and propagated by the next solve()
+    if (add_buffer_.size() == 1) {
+        assign(add_buffer_[0].var_id(), add_buffer_[0].is_positive(), 0, kNoClause);
+        return kNoClause;
+    }
+
+    if (add_buffer_.size() == 2) {
+        add_binary(add_buffer_[0], add_buffer_[1]);
+        return kNoClause;
+    }
+
+    return ca_.alloc(add_buffer_.data(), add_buffer_.size(), false);
+}
+
+void Solver::attach_originals(size_t first) {
+    std::vector<uint32_t> num_watches(watches_.size());
+    for (size_t i = first; i < clauses_.size(); i++) {
+        const Clause& clause = ca_[clauses_[i]];
+        num_watches[watch_index(clause[0])]++;
+        num_watches[watch_index(clause[1])]++;
+    }
+    for (size_t index = 0; index < watches_.size(); index++) {
+        if (num_watches[index] > 0) {
+            watches_[index].reserve(watches_[index].size() + num_watches[index]);
+        }
+    }
+    for (size_t i = first; i < clauses_.size(); i++) {
+        attach_watches(clauses_[i]);
+    }
+}
+
+void Solver::add_formula(Formula formula) {
+    static_assert(Formula::kHeaderWords == ClauseAllocator::kHeaderWords,
+                  "Formula must use the clause arena layout");
+    grow_variables(formula.num_variables());
+    if (formula.has_empty_clause()) {
+        ok_ = false;
+    }
+    if (!ok_) {
+        return;
+    }
+    backtrack(0);
+
+    // Clauses over variables that are already assigned would miss the
+    // propagation of those assignments; they take the simplifying path
+    bool simplify = !trail_.empty();
+    auto assigned = [&](const Literal* begin, const Literal* end) {
+        return std::any_of(begin, end, [&](const Literal& lit) { return assignments_[lit.var_id()].level >= 0; });
+    };
+
+    // Units and binaries never enter the arena, so without assigned
+    // variables the adopted clauses are used as they are
+    ClauseRef base = ca_.adopt(std::move(formula.words_));
+    size_t first = clauses_.size();
+    clauses_.reserve(clauses_.size() + formula.offsets_.size());
+    for (uint32_t offset : formula.offsets_) {
+        ClauseRef cref = base + offset;
+        const Clause& clause = ca_[cref];
+        if (simplify && assigned(clause.begin(), clause.end())) {
+            // store_clause copies the literals out before the arena grows
+            ca_.free(cref);
+            cref = store_clause(clause.begin(), clause.size());
+            if (cref != kNoClause) {
+                clauses_.push_back(cref);
+            }
+        } else {
+            clauses_.push_back(cref);
+        }
+    }
+    for (size_t i = 0; i < formula.binaries_.size(); i += 2) {
+        const Literal* binary = &formula.binaries_[i];
+        if (simplify && assigned(binary, binary + 2)) {
+            store_clause(binary, 2);
+        } else {
+            add_binary(binary[0], binary[1]);
+        }
+    }
+    for (const Literal& unit : formula.units_) {
+        if (is_false(unit)) {
+            ok_ = false;
+        } else if (!is_true(unit)) {
+            assign(unit.var_id(), unit.is_positive(), 0, kNoClause);
+        }
+    }
+    attach_originals(first);
+
+    for (const auto& constraint : formula.xors_) {
+        if (native_xor_) {
+            xor_engine_.add(constraint);
+            continue;
+        }
+        std::vector<std::vector<Literal>> cnf_clauses;
+        encode_xor(constraint, cnf_clauses, nullptr);
+        for (const auto& clause : cnf_clauses) {
+            add_clause(clause);
+        }
+    }
+    check_garbage();
+}
+
+void Solver::add_binary(const Literal& a, const Literal& b) {
+    binary_watches_[watch_index(a)].push_back(b);
+    binary_watches_[watch_index(b)].push_back(a);
+    num_binary_++;
+}
+
+Solver::ClauseRef Solver::add_clause_to_arena(const std::vector<Literal>& literals, bool learnt) {
+    ClauseRef cref = ca_.alloc(literals.data(), literals.size(), learnt);
+    if (literals.size() > 1) {
+        attach_watches(cref);
+    }
+    if (learnt) {
+        learnts_.push_back(cref);
     } else {
-        // Set up watched literals
-        attach_watch(clause, 0);
-        if (literals.size() > 1) {
-            attach_watch(clause, 1);
+        clauses_.push_back(cref);
+    }
+    return cref;
+}
+
+void Solver::add_xor(const std::vector<Literal>& xor_lits) {
+    XorConstraint constraint = normalize_xor(xor_lits);
+    if (constraint.vars.empty()) {
+        if (constraint.rhs) {
+            // 0 = 1
+            ok_ = false;
+        }
+        return;
+    }
+
+    if (native_xor_) {
+        xor_engine_.add(constraint);
+        return;
+    }
+    std::vector<std::vector<Literal>> cnf_clauses;
+    encode_xor(constraint, cnf_clauses, nullptr);
+    for (const auto& clause : cnf_clauses) {
+        add_clause(clause);
+    }
+}
+
+XorConstraint Solver::normalize_xor(const std::vector<Literal>& xor_lits) {
+    // x XOR ... = 1, with a negative literal flipping the parity
+    XorConstraint constraint{{}, true};
+    for (const auto& lit : xor_lits) {
+        constraint.vars.push_back(lit.var_id());
+        if (!lit.is_positive()) constraint.rhs = !constraint.rhs;
+    }
+
+    // Repeated variables cancel out
+    std::sort(constraint.vars.begin(), constraint.vars.end());
+    std::vector<uint32_t> vars;
+    for (size_t i = 0; i < constraint.vars.size(); i++) {
+        if (i + 1 < constraint.vars.size() && constraint.vars[i] == constraint.vars[i + 1]) {
+            i++;
+            continue;
         }
+        vars.push_back(constraint.vars[i]);
     }
-    
-    clauses_.push_back(clause);
+    constraint.vars = std::move(vars);
+    return constraint;
 }
 
-void Solver::attach_watch(const std::shared_ptr<Clause>& clause, size_t watch_idx) {
-    const auto& lit = clause->literals[watch_idx];
-    uint32_t watch_list = lit.var_id() * 2 + !lit.is_positive();
-    watches_[watch_list].push_back(clause);
+uint32_t Solver::new_group() {
+    groups_.push_back(Group{{}, {}, kNoVar, false, true, false});
+    return groups_.size() - 1;
 }
 
-void Solver::detach_watch(const std::shared_ptr<Clause>& clause, size_t watch_idx) {
-    const auto& lit = clause->literals[watch_idx];
-    uint32_t watch_list = lit.var_id() * 2 + !lit.is_positive();
-    auto& watch_vector = watches_[watch_list];
-    
-    auto it = std::find(watch_vector.begin(), watch_vector.end(), clause);
-    if (it != watch_vector.end()) {
-        watch_vector.erase(it);
+uint32_t Solver::new_internal_var() {
+    if (!free_internal_vars_.empty()) {
+        uint32_t var = free_internal_vars_.back();
+        free_internal_vars_.pop_back();
+        return var;
     }
+    uint32_t var = new_var();
+    is_internal_[var] = 1;
+    return var;
 }
 
-bool Solver::update_watches(const std::shared_ptr<Clause>& clause, const Literal& false_lit) {
-    // Find the false watch index
-    size_t false_idx = clause->watched[0];
-    if (clause->literals[clause->watched[1]].var_id() == false_lit.var_id()) {
-        false_idx = clause->watched[1];
+void Solver::add_clause(const std::vector<Literal>& literals, uint32_t group) {
+    assert(group < groups_.size() && !groups_[group].released);
+    Group& g = groups_[group];
+    if (g.clause_var == kNoVar) {
+        g.clause_var = new_internal_var();
+        g.activation_vars.push_back(g.clause_var);
     }
-    
-    // Look for a new non-false literal to watch
-    for (size_t i = 0; i < clause->literals.size(); i++) {
-        if (i == clause->watched[0] || i == clause->watched[1]) continue;
-        
-        const auto& lit = clause->literals[i];
-        uint32_t var = lit.var_id();
-        
-        if (assignments_[var].level == -1 ||  // Unassigned
-            assignments_[var].value == lit.is_positive()) {  // Satisfying
-            
-            // Update watches
-            detach_watch(clause, false_idx);
-            clause->watched[false_idx == clause->watched[0] ? 0 : 1] = i;
-            attach_watch(clause, i);
-            
-            return true;
+    g.has_clauses = true;
+
+    // C ∨ a, with a assumed false while the group is active
+    std::vector<Literal> guarded(literals);
+    guarded.push_back(Literal(g.clause_var, true));
+    add_clause(guarded);
+}
+
+void Solver::add_xor(const std::vector<Literal>& xor_lits, uint32_t group) {
+    assert(group < groups_.size() && !groups_[group].released);
+    // x1 ⊕ ... ⊕ xn ⊕ a with its own a: once a is unconstrained the row
+    // no longer restricts the other variables
+    uint32_t var = new_internal_var();
+    groups_[group].activation_vars.push_back(var);
+    std::vector<Literal> guarded(xor_lits);
+    guarded.push_back(Literal(var, true));
+    if (native_xor_) {
+        add_xor(guarded);
+        return;
+    }
+
+    // Chunk links are retracted with the group
+    groups_[group].has_clauses = true;
+    std::vector<std::vector<Literal>> cnf_clauses;
+    encode_xor(normalize_xor(guarded), cnf_clauses, &groups_[group].aux_vars);
+    for (const auto& clause : cnf_clauses) {
+        add_clause(clause);
+    }
+}
+
+void Solver::release_group(uint32_t group) {
+    assert(group < groups_.size());
+    Group& g = groups_[group];
+    if (g.released) {
+        return;
+    }
+    backtrack(0);
+
+    // Activation variables only occur in the group's own constraints and
+    // in learnt clauses derived from them, so dropping every clause that
+    // mentions one retracts the group and nothing else
+    std::vector<uint32_t> vars(g.activation_vars);
+    vars.insert(vars.end(), g.aux_vars.begin(), g.aux_vars.end());
+    remove_clauses_with(vars, g.has_clauses);
+    xor_engine_.remove_containing(g.activation_vars);
+
+    for (uint32_t var : vars) {
+        if (assignments_[var].level == -1) {
+            free_internal_vars_.push_back(var);
         }
     }
-    
-    return false;  // No new watch found
+    g.activation_vars.clear();
+    g.aux_vars.clear();
+    g.clause_var = kNoVar;
+    g.has_clauses = false;
+    g.released = true;
+}
+
+void Solver::set_group_enabled(uint32_t group, bool enabled) {
+    assert(group < groups_.size());
+    groups_[group].enabled = enabled;
+}
+
+void Solver::remove_clauses_with(const std::vector<uint32_t>& vars, bool originals) {
+    for (uint32_t var : vars) {
+        seen_[var] = 1;
+    }
+
+    // Binary clauses: unlink each one from the other literal's list
+    for (uint32_t var : vars) {
+        for (uint32_t index : {watch_index(Literal(var, true)), watch_index(Literal(var, false))}) {
+            for (const Literal& other : binary_watches_[index]) {
+                auto& other_list = binary_watches_[watch_index(other)];
+                other_list.erase(std::remove_if(other_list.begin(), other_list.end(),
+                                                [var](const Literal& lit) { return lit.var_id() == var; }),
+                                 other_list.end());
+                num_binary_--;
+            }
+            binary_watches_[index].clear();
+        }
+    }
+
+    // Long clauses: free them and clean only the lists that watch them
+    std::vector<uint32_t> dirty_lists;
+    auto remove_marked = [&](std::vector<ClauseRef>& list) {
+        size_t j = 0;
+        for (ClauseRef cref : list) {
+            Clause& clause = ca_[cref];
+            bool marked = std::any_of(clause.begin(), clause.end(),
+                                      [this](const Literal& lit) { return seen_[lit.var_id()]; });
+            if (marked) {
+                dirty_lists.push_back(watch_index(clause[0]));
+                dirty_lists.push_back(watch_index(clause[1]));
+                ca_.free(cref);
+            } else {
+                list[j++] = cref;
+            }
+        }
+        list.resize(j);
+    };
+    remove_marked(learnts_);
+    if (originals) {
+        remove_marked(clauses_);
+    }
+    std::sort(dirty_lists.begin(), dirty_lists.end());
+    dirty_lists.erase(std::unique(dirty_lists.begin(), dirty_lists.end()), dirty_lists.end());
+    for (uint32_t index : dirty_lists) {
+        purge_watches(index);
+    }
+
+    // Reasons of level-0 assignments are never analyzed
+    for (uint32_t var : trail_) {
+        ClauseRef& reason = assignments_[var].reason;
+        if (is_arena_reason(reason) && ca_[reason].removed()) {
+            reason = kNoClause;
+        }
+    }
+
+    for (uint32_t var : vars) {
+        seen_[var] = 0;
+    }
+    check_garbage();
+}
+
+void Solver::clear_clauses() {
+    backtrack(0);
+    // Reasons of level-0 assignments are never analyzed
+    for (uint32_t var : trail_) {
+        ClauseRef& reason = assignments_[var].reason;
+        if (is_arena_reason(reason) && ca_[reason].is_xor_reason()) {
+            ca_.free(reason);
+        }
+        reason = kNoClause;
+    }
+    for (ClauseRef cref : clauses_) {
+        ca_.free(cref);
+    }
+    for (ClauseRef cref : learnts_) {
+        ca_.free(cref);
+    }
+    clauses_.clear();
+    learnts_.clear();
+    for (auto& watch_list : watches_) {
+        watch_list.clear();
+    }
+    for (auto& implied : binary_watches_) {
+        implied.clear();
+    }
+    num_binary_ = 0;
+    check_garbage();
+}
+
+void Solver::attach_watches(ClauseRef cref) {
+    const Clause& clause = ca_[cref];
+    watches_[watch_index(clause[0])].push_back({cref, clause[1]});
+    watches_[watch_index(clause[1])].push_back({cref, clause[0]});
 }
 
-bool Solver::assign(uint32_t var, bool value, int level, const std::shared_ptr<Clause>& reason) {
+bool Solver::assign(uint32_t var, bool value, int level, ClauseRef reason) {
     assignments_[var] = Assignment{level, value, reason};
     trail_.push_back(var);
-    propagation_queue_.push_back(var);
     return true;
 }
 
 void Solver::unassign(uint32_t var) {
-    assignments_[var] = Assignment{-1, false, nullptr};
+    // XOR reasons are materialized per implication and die with it
+    ClauseRef reason = assignments_[var].reason;
+    if (is_arena_reason(reason) && ca_[reason].is_xor_reason()) {
+        ca_.free(reason);
+    }
+    assignments_[var] = Assignment{-1, false, kNoClause};
 }
 
 bool Solver::propagate() {
-    while (!propagation_queue_.empty()) {
-        uint32_t var = propagation_queue_.back();
-        propagation_queue_.pop_back();
-        
-        bool value = assignments_[var].value;
-        uint32_t watch_idx = var * 2 + value;  // Watch list for false literal
-        
-        auto& watch_list = watches_[watch_idx];
-        for (size_t i = 0; i < watch_list.size();) {
-            auto clause = watch_list[i];
-            
-            if (update_watches(clause, Literal(var, !value))) {
-                i++;
-                continue;
-            }
-            
-            // No new watch found - check other watched literal
-            size_t other_idx = clause->watched[0];
-            if (clause->literals[clause->watched[0]].var_id() == var) {
-                other_idx = clause->watched[1];
-            }
-            
-            const auto& other_lit = clause->literals[other_idx];
-            uint32_t other_var = other_lit.var_id();
-            
-            // If other watch is true, clause satisfied
-            if (assignments_[other_var].level != -1 && 
-                assignments_[other_var].value == other_lit.is_positive()) {
-                i++;
-                continue;
-            }
-            
-            // If other watch is unassigned, propagate it
-            if (assignments_[other_var].level == -1) {
-                if (!assign(other_var, other_lit.is_positive(), 
-                          decision_level_, clause)) {
-                    conflict_clause_ = clause;
+    do {
+        while (qhead_ < trail_.size()) {
+            // Binary implications of every pending assignment go first
+            while (bin_qhead_ < trail_.size()) {
+                uint32_t var = trail_[bin_qhead_++];
+                if (!propagate_binary(Literal(var, !assignments_[var].value))) {
                     return false;
                 }
-                i++;
-                continue;
             }
-            
-            // Conflict
-            conflict_clause_ = clause;
+
+            uint32_t var = trail_[qhead_++];
+            XOR_SMC_STAT(stats_.propagations++);
+            if (!propagate_long(Literal(var, !assignments_[var].value))) {
+                return false;
+            }
+        }
+
+        if (!propagate_xors()) {
             return false;
         }
-    }
+    } while (qhead_ < trail_.size());
     
     return true;
 }
 
-std::shared_ptr<Solver::Clause> Solver::analyze_conflict(
-    const std::shared_ptr<Clause>& conflict) {
-    
-    std::vector<Literal> learnt_literals;
-    std::unordered_set<uint32_t> seen_vars;
-    int counter = 0;
-    int conflict_level = decision_level_;
-    
-    // Add literals from conflict clause
-    for (const auto& lit : conflict->literals) {
-        uint32_t var = lit.var_id();
-        if (assignments_[var].level > 0) {
-            seen_[var] = true;
-            seen_vars.insert(var);
-            if (assignments_[var].level == conflict_level) {
-                counter++;
+bool Solver::propagate_binary(const Literal& false_lit) {
+    for (const Literal& other : binary_watches_[watch_index(false_lit)]) {
+        XOR_SMC_STAT(stats_.binary_watch_visits++);
+        if (is_true(other)) {
+            continue;
+        }
+        if (is_false(other)) {
+            conflict_clause_ = binary_reason(other);
+            conflict_binary_[0] = false_lit;
+            conflict_binary_[1] = other;
+            return false;
+        }
+        assign(other.var_id(), other.is_positive(), decision_level_, binary_reason(false_lit));
+    }
+    return true;
+}
+
+bool Solver::propagate_long(const Literal& false_lit) {
+    auto& watch_list = watches_[watch_index(false_lit)];
+
+    // Watchers that stay are compacted in place: i reads, j writes
+    size_t i = 0, j = 0;
+    while (i < watch_list.size()) {
+        Watcher watcher = watch_list[i++];
+        if (is_true(watcher.blocker)) {
+            watch_list[j++] = watcher;
+            continue;
+        }
+
+        // Make sure the false literal is at position 1
+        Clause& clause = ca_[watcher.cref];
+        if (clause[0] == false_lit) {
+            std::swap(clause[0], clause[1]);
+        }
+
+        // If the other watch is true, clause satisfied
+        Literal first = clause[0];
+        Watcher updated{watcher.cref, first};
+        if (first != watcher.blocker && is_true(first)) {
+            watch_list[j++] = updated;
+            continue;
+        }
+
+        // Look for a new non-false literal to watch
+        bool moved = false;
+        for (uint32_t k = 2; k < clause.size(); k++) {
+            if (!is_false(clause[k])) {
+                clause[1] = clause[k];
+                clause[k] = false_lit;
+                watches_[watch_index(clause[1])].push_back(updated);
+                moved = true;
+                break;
+            }
+        }
+        if (moved) {
+            continue;
+        }
+
+        watch_list[j++] = updated;
+
+        // Conflict
+        if (is_false(first)) {
+            XOR_SMC_STAT(stats_.watch_visits += i);
+            conflict_clause_ = watcher.cref;
+            while (i < watch_list.size()) {
+                watch_list[j++] = watch_list[i++];
             }
+            watch_list.resize(j);
+            return false;
         }
+
+        // Other watch is unassigned, propagate it
+        assign(first.var_id(), first.is_positive(), decision_level_, watcher.cref);
     }
-    
-    // Process trail for First UIP
-    for (int i = trail_.size() - 1; i >= 0 && counter > 0; i--) {
-        uint32_t var = trail_[i];
-        
-        if (!seen_[var]) continue;
-        
-        seen_[var] = false;
-        seen_vars.erase(var);
-        
-        const auto& reason = assignments_[var].reason;
-        if (!reason) continue;
-        
-        for (const auto& lit : reason->literals) {
-            uint32_t reason_var = lit.var_id();
-            if (reason_var == var) continue;
-            
-            if (!seen_[reason_var] && assignments_[reason_var].level > 0) {
-                seen_[reason_var] = true;
-                seen_vars.insert(reason_var);
-                if (assignments_[reason_var].level == conflict_level) {
-                    counter++;
+    XOR_SMC_STAT(stats_.watch_visits += i);
+    watch_list.resize(j);
+    return true;
+}
+
+bool Solver::propagate_xors() {
+    if (xor_engine_.num_rows() == 0) {
+        return true;
+    }
+
+    if (xor_engine_.dirty()) {
+        if (!xor_engine_.recheck()) {
+            const auto& conflict = xor_engine_.conflict();
+            conflict_clause_ = ca_.alloc(conflict.data(), conflict.size(), false, true);
+            xor_engine_.clear_implications();
+            return false;
+        }
+        if (!enqueue_xor_implications()) {
+            return false;
+        }
+    }
+
+    while (xor_qhead_ < trail_.size()) {
+        uint32_t var = trail_[xor_qhead_++];
+        if (!xor_engine_.assign(var, assignments_[var].value)) {
+            const auto& conflict = xor_engine_.conflict();
+            conflict_clause_ = ca_.alloc(conflict.data(), conflict.size(), false, true);
+            xor_engine_.clear_implications();
+            return false;
+        }
+        if (!enqueue_xor_implications()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Solver::enqueue_xor_implications() {
+    for (const auto& imp : xor_engine_.implications()) {
+        const Literal* reason = xor_engine_.reason_literals(imp);
+        uint32_t var = imp.lit.var_id();
+
+        if (assignments_[var].level == -1) {
+            assign(var, imp.lit.is_positive(), decision_level_,
+                   ca_.alloc(reason, imp.reason_size, false, true));
+        } else if (assignments_[var].value != imp.lit.is_positive()) {
+            // The implied literal is already false: the reason is falsified
+            conflict_clause_ = ca_.alloc(reason, imp.reason_size, false, true);
+            xor_engine_.clear_implications();
+            return false;
+        }
+    }
+    xor_engine_.clear_implications();
+    return true;
+}
+
+LiteralSpan Solver::reason_literals(uint32_t var) {
+    ClauseRef reason = assignments_[var].reason;
+    if (is_binary_reason(reason)) {
+        reason_buffer_[0] = Literal(var, assignments_[var].value);
+        reason_buffer_[1] = literal_at(reason & ~kBinaryReason);
+        return {reason_buffer_, 2};
+    }
+    const Clause& clause = ca_[reason];
+    return {clause.begin(), clause.size()};
+}
+
+LiteralSpan Solver::conflict_literals() {
+    if (is_binary_reason(conflict_clause_)) {
+        return {conflict_binary_, 2};
+    }
+    const Clause& clause = ca_[conflict_clause_];
+    return {clause.begin(), clause.size()};
+}
+
+template <typename Lits>
+uint32_t Solver::compute_lbd(const Lits& literals) {
+    lbd_stamp_++;
+    uint32_t lbd = 0;
+    for (const auto& lit : literals) {
+        int level = assignments_[lit.var_id()].level;
+        if (level >= 0 && level_stamp_[level] != lbd_stamp_) {
+            level_stamp_[level] = lbd_stamp_;
+            lbd++;
+        }
+    }
+    return lbd;
+}
+
+void Solver::analyze_conflict(std::vector<Literal>& learnt_clause) {
+    learnt_clause.clear();
+    learnt_clause.push_back(Literal());  // Room for the asserting literal
+
+    if (is_arena_reason(conflict_clause_) && ca_[conflict_clause_].learnt()) {
+        update_learnt_clause(conflict_clause_);
+    }
+
+    // Resolve backwards along the trail until a single literal of the
+    // conflict level remains: the first unique implication point
+    LiteralSpan literals = conflict_literals();
+    int path_count = 0;
+    size_t index = trail_.size();
+    int64_t resolved_var = -1;
+    do {
+        for (const auto& lit : literals) {
+            uint32_t var = lit.var_id();
+            if (static_cast<int64_t>(var) == resolved_var) continue;
+
+            if (!seen_[var] && assignments_[var].level > 0) {
+                seen_[var] = 1;
+                bump_activity(var);
+                if (assignments_[var].level >= decision_level_) {
+                    path_count++;
+                } else {
+                    learnt_clause.push_back(lit);
                 }
             }
         }
-        
-        counter--;
+
+        // Next marked variable on the trail
+        while (!seen_[trail_[--index]]) {}
+        resolved_var = trail_[index];
+        seen_[resolved_var] = 0;
+        path_count--;
+
+        if (path_count > 0) {
+            ClauseRef reason = assignments_[resolved_var].reason;
+            if (is_arena_reason(reason) && ca_[reason].learnt()) {
+                update_learnt_clause(reason);
+            }
+            literals = reason_literals(resolved_var);
+        }
+    } while (path_count > 0);
+    learnt_clause[0] = Literal(resolved_var, !assignments_[resolved_var].value);
+
+    // Recursive minimization: drop literals implied by the rest of the clause
+    analyze_toclear_.assign(learnt_clause.begin(), learnt_clause.end());
+    uint32_t abstract_levels = 0;
+    for (size_t i = 1; i < learnt_clause.size(); i++) {
+        abstract_levels |= abstract_level(learnt_clause[i].var_id());
+    }
+    size_t j = 1;
+    for (size_t i = 1; i < learnt_clause.size(); i++) {
+        uint32_t var = learnt_clause[i].var_id();
+        if (assignments_[var].reason == kNoClause ||
+            !literal_redundant(learnt_clause[i], abstract_levels)) {
+            learnt_clause[j++] = learnt_clause[i];
+        }
+    }
+    learnt_clause.resize(j);
+
+    if (learnt_clause.size() <= kBinaryMinimizeSize) {
+        minimize_with_binaries(learnt_clause);
+    }
+
+    // The literal with the highest remaining level is watched second
+    if (learnt_clause.size() > 1) {
+        size_t max_i = 1;
+        for (size_t i = 2; i < learnt_clause.size(); i++) {
+            if (assignments_[learnt_clause[i].var_id()].level >
+                assignments_[learnt_clause[max_i].var_id()].level) {
+                max_i = i;
+            }
+        }
+        std::swap(learnt_clause[1], learnt_clause[max_i]);
     }
-    
-    // Build learnt clause
-    for (uint32_t var : seen_vars) {
-        learnt_literals.push_back(
-            Literal(var, !assignments_[var].value)
-        );
+
+    for (const auto& lit : analyze_toclear_) {
+        seen_[lit.var_id()] = 0;
     }
-    
-    return std::make_shared<Clause>(learnt_literals);
+    assert(learnt_clause_ordered(learnt_clause));
 }
 
-int Solver::compute_backtrack_level(const std::shared_ptr<Clause>& learnt_clause) {
-    int max_level = 0;
-    int second_max_level = 0;
-    
-    for (const auto& lit : learnt_clause->literals) {
+bool Solver::learnt_clause_ordered(const std::vector<Literal>& learnt_clause) const {
+    std::vector<uint32_t> vars;
+    for (size_t i = 0; i < learnt_clause.size(); i++) {
+        const Literal& lit = learnt_clause[i];
         int level = assignments_[lit.var_id()].level;
-        if (level > max_level) {
-            second_max_level = max_level;
-            max_level = level;
-        } else if (level > second_max_level && level < max_level) {
-            second_max_level = level;
+        if (!is_false(lit) || (i == 0) != (level == decision_level_) ||
+            (i > 1 && level > assignments_[learnt_clause[1].var_id()].level)) {
+            return false;
         }
+        vars.push_back(lit.var_id());
     }
-    
-    return second_max_level;
+    std::sort(vars.begin(), vars.end());
+    return std::adjacent_find(vars.begin(), vars.end()) == vars.end();
+}
+
+void Solver::analyze_final(const Literal& assumption) {
+    // Collect the assumption decisions the falsified assumption depends on
+    failed_assumptions_.clear();
+    if (!is_internal_[assumption.var_id()]) {
+        failed_assumptions_.push_back(assumption);
+    }
+    if (assignments_[assumption.var_id()].level == 0) {
+        return;
+    }
+
+    seen_[assumption.var_id()] = 1;
+    for (size_t i = trail_.size(); i-- > 0;) {
+        uint32_t var = trail_[i];
+        if (assignments_[var].level == 0) {
+            break;
+        }
+        if (!seen_[var]) {
+            continue;
+        }
+        seen_[var] = 0;
+
+        if (assignments_[var].reason == kNoClause) {
+            // Only assumptions are decided on the levels below this one
+            if (!is_internal_[var]) {
+                failed_assumptions_.push_back(Literal(var, assignments_[var].value));
+            }
+            continue;
+        }
+        for (const auto& lit : reason_literals(var)) {
+            if (lit.var_id() != var && assignments_[lit.var_id()].level > 0) {
+                seen_[lit.var_id()] = 1;
+            }
+        }
+    }
+    seen_[assumption.var_id()] = 0;
+}
+
+bool Solver::literal_redundant(const Literal& lit, uint32_t abstract_levels) {
+    analyze_stack_.clear();
+    analyze_stack_.push_back(lit);
+    size_t top = analyze_toclear_.size();
+
+    while (!analyze_stack_.empty()) {
+        uint32_t var = analyze_stack_.back().var_id();
+        analyze_stack_.pop_back();
+
+        for (const auto& reason_lit : reason_literals(var)) {
+            uint32_t reason_var = reason_lit.var_id();
+            if (reason_var == var || seen_[reason_var] || assignments_[reason_var].level == 0) {
+                continue;
+            }
+            // Only follow implied variables on levels present in the clause
+            if (assignments_[reason_var].reason != kNoClause &&
+                (abstract_level(reason_var) & abstract_levels)) {
+                seen_[reason_var] = 1;
+                analyze_stack_.push_back(reason_lit);
+                analyze_toclear_.push_back(reason_lit);
+            } else {
+                for (size_t k = top; k < analyze_toclear_.size(); k++) {
+                    seen_[analyze_toclear_[k].var_id()] = 0;
+                }
+                analyze_toclear_.resize(top);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Solver::minimize_with_binaries(std::vector<Literal>& learnt_clause) {
+    // A binary clause (uip ∨ b) with b true resolves ¬b out of the clause
+    bool removed = false;
+    for (const Literal& other : binary_watches_[watch_index(learnt_clause[0])]) {
+        uint32_t var = other.var_id();
+        if (seen_[var] == 1 && is_true(other)) {
+            seen_[var] = 2;
+            removed = true;
+        }
+    }
+    if (!removed) {
+        return;
+    }
+
+    size_t j = 1;
+    for (size_t i = 1; i < learnt_clause.size(); i++) {
+        uint32_t var = learnt_clause[i].var_id();
+        if (seen_[var] == 2) {
+            seen_[var] = 1;
+        } else {
+            learnt_clause[j++] = learnt_clause[i];
+        }
+    }
+    learnt_clause.resize(j);
+}
+
+int Solver::compute_backtrack_level(const std::vector<Literal>& learnt_clause) {
+    // analyze_conflict puts the highest level below the conflict second
+    return learnt_clause.size() > 1 ? assignments_[learnt_clause[1].var_id()].level : 0;
 }
 
 void Solver::backtrack(int level) {
     while (!trail_.empty() && assignments_[trail_.back()].level > level) {
         uint32_t var = trail_.back();
+        if (trail_.size() <= xor_qhead_) {
+            xor_engine_.unassign(var);
+        }
+        polarity_[var] = assignments_[var].value;
         unassign(var);
-        seen_[var] = false;
+        order_heap_.insert(var, activity_);
         trail_.pop_back();
     }
     
-    propagation_queue_.clear();
+    qhead_ = std::min(qhead_, trail_.size());
+    bin_qhead_ = std::min(bin_qhead_, trail_.size());
+    xor_qhead_ = std::min(xor_qhead_, trail_.size());
     decision_level_ = level;
 }
 
+void Solver::bump_activity(uint32_t var) {
+    if ((activity_[var] += var_inc_) > 1e100) {
+        // Rescale everything to stay within double range
+        for (double& a : activity_) {
+            a *= 1e-100;
+        }
+        var_inc_ *= 1e-100;
+    }
+    order_heap_.increased(var, activity_);
+}
+
+void Solver::decay_activities() {
+    var_inc_ /= var_decay_;
+}
+
+int Solver::pick_branch_var() {
+    while (!order_heap_.empty()) {
+        uint32_t var = order_heap_.pop_max(activity_);
+        if (assignments_[var].level == -1) {
+            return var;
+        }
+    }
+    return -1;
+}
+
+void Solver::bump_clause_activity(Clause& clause) {
+    if ((clause.activity() += clause_inc_) > 1e20) {
+        for (ClauseRef cref : learnts_) {
+            ca_[cref].activity() *= 1e-20;
+        }
+        clause_inc_ *= 1e-20;
+    }
+}
+
+void Solver::update_learnt_clause(ClauseRef cref) {
+    Clause& clause = ca_[cref];
+    bump_clause_activity(clause);
+    clause.set_used(true);
+
+    // Promote the clause if its LBD improved since it was learnt
+    if (clause.tier() != Tier::Core) {
+        uint32_t lbd = compute_lbd(clause);
+        if (lbd < clause.lbd()) {
+            clause.set_lbd(lbd);
+            if (lbd <= kCoreLbd) {
+                clause.set_tier(Tier::Core);
+            } else if (lbd <= kTier2Lbd) {
+                clause.set_tier(Tier::Tier2);
+            }
+        }
+    }
+}
+
+bool Solver::locked(ClauseRef cref) const {
+    const Clause& clause = ca_[cref];
+    const Assignment& a = assignments_[clause[0].var_id()];
+    return a.reason == cref && a.level != -1 && a.value == clause[0].is_positive();
+}
+
+void Solver::reduce_db() {
+    XOR_SMC_STAT(stats_.reductions++);
+    ScopedTimer timer(stats_.reduce_seconds);
+
+    // Tier-2 clauses unused since the last reduction fall back to local
+    std::vector<ClauseRef> candidates;
+    for (ClauseRef cref : learnts_) {
+        Clause& clause = ca_[cref];
+        if (clause.tier() == Tier::Tier2 && !clause.used()) {
+            clause.set_tier(Tier::Local);
+        } else if (clause.tier() == Tier::Local && !locked(cref)) {
+            candidates.push_back(cref);
+        }
+        clause.set_used(false);
+    }
+
+    // Drop the less active half of the local tier, worse LBD first on ties
+    std::sort(candidates.begin(), candidates.end(), [this](ClauseRef a, ClauseRef b) {
+        const Clause& ca = ca_[a];
+        const Clause& cb = ca_[b];
+        if (ca.activity() != cb.activity()) {
+            return ca.activity() < cb.activity();
+        }
+        return ca.lbd() > cb.lbd();
+    });
+    for (size_t i = 0; i < candidates.size() / 2; i++) {
+        ca_.free(candidates[i]);
+    }
+
+    // Clean watch lists and the learnt list in one sweep each
+    for (uint32_t index = 0; index < watches_.size(); index++) {
+        purge_watches(index);
+    }
+    learnts_.erase(std::remove_if(learnts_.begin(), learnts_.end(),
+                                  [this](ClauseRef cref) { return ca_[cref].removed(); }),
+                   learnts_.end());
+
+    check_garbage();
+}
+
+void Solver::purge_watches(uint32_t index) {
+    auto& watch_list = watches_[index];
+    watch_list.erase(std::remove_if(watch_list.begin(), watch_list.end(),
+                                    [this](const Watcher& w) { return ca_[w.cref].removed(); }),
+                     watch_list.end());
+}
+
 bool Solver::solve() {
-    std::cout << "\nStarting solve with " << clauses_.size() 
-              << " clauses and " << assignments_.size() << " variables\n";
+    return solve({});
+}
+
+bool Solver::solve(const std::vector<Literal>& assumptions) {
+    XOR_SMC_STAT(stats_.solves++);
+    ScopedTimer timer(stats_.solve_seconds);
+    XOR_SMC_DEBUG("Starting solve with " << clauses_.size()
+                  << " clauses and " << assignments_.size() << " variables");
     
+    backtrack(0);
+    failed_assumptions_.clear();
+    interrupted_ = false;
+    model_.clear();
+
     // Check for empty clauses
-    for (const auto& clause : clauses_) {
-        if (clause->literals.empty()) {
-            std::cout << "Formula contains empty clause - UNSAT\n";
-            return false;
+    if (!ok_) {
+        XOR_SMC_DEBUG("Formula contains empty clause - UNSAT");
+        return false;
+    }
+
+    // Assumption i is decided on level i + 1; active groups follow the
+    // user's assumptions
+    assumptions_.assign(assumptions.begin(), assumptions.end());
+    for (const Group& group : groups_) {
+        if (!group.enabled) {
+            continue;
+        }
+        for (uint32_t var : group.activation_vars) {
+            assumptions_.push_back(Literal(var, false));
         }
     }
-    
-    // Initial propagation
-    if (!propagate()) {
-        std::cout << "Conflict during initial propagation - UNSAT\n";
-        return false;
+    if (level_stamp_.size() < assignments_.size() + assumptions_.size() + 1) {
+        level_stamp_.resize(assignments_.size() + assumptions_.size() + 1, 0);
     }
     
-    while (true) {
-        // Find unassigned variable
-        int next_var = -1;
-        for (size_t i = 0; i < assignments_.size(); i++) {
-            if (assignments_[i].level == -1) {
-                next_var = i;
-                break;
-            }
+    // Eliminate the XOR system; the engine then re-reads the whole trail
+    if (xor_engine_.needs_build()) {
+        xor_qhead_ = 0;
+        bool consistent;
+        {
+            ScopedTimer build_timer(stats_.xor_build_seconds);
+            consistent = xor_engine_.build(assignments_.size());
         }
-        
-        // No unassigned variables - SAT
-        if (next_var == -1) {
-            std::cout << "All variables assigned - SAT\n";
-            return true;
+        if (!consistent) {
+            XOR_SMC_DEBUG("Inconsistent XOR system - UNSAT");
+            ok_ = false;
+            return false;
         }
-        
-        // Make decision
-        decision_level_++;
-        
-        if (!assign(next_var, true, decision_level_, nullptr) || 
-            !propagate()) {
-            
+    }
+
+    while (true) {
+        if (!propagate()) {
+            if (decision_level_ == 0) {
+                XOR_SMC_DEBUG("Conflict at decision level 0 - UNSAT");
+                ok_ = false;
+                return false;
+            }
+
             // Analyze conflict and learn clause
-            auto learnt_clause = analyze_conflict(conflict_clause_);
-            if (learnt_clause->literals.empty() || decision_level_ == 0) {
-                std::cout << "Learned empty clause - UNSAT\n";
+            std::vector<Literal>& learnt_literals = learnt_clause_;
+            {
+                ScopedTimer analyze_timer(stats_.analyze_seconds);
+                analyze_conflict(learnt_literals);
+            }
+            if (is_arena_reason(conflict_clause_) && ca_[conflict_clause_].is_xor_reason()) {
+                ca_.free(conflict_clause_);
+            }
+            conflict_clause_ = kNoClause;
+            if (learnt_literals.empty()) {
+                XOR_SMC_DEBUG("Learned empty clause - UNSAT");
+                ok_ = false;
                 return false;
             }
             
-            int backtrack_level = compute_backtrack_level(learnt_clause);
+            num_conflicts_++;
+            uint32_t lbd = compute_lbd(learnt_literals);
+            XOR_SMC_STAT(stats_.conflicts++;
+                         stats_.learnt_literals += learnt_literals.size();
+                         histogram_add(stats_.learnt_size_histogram, learnt_literals.size());
+                         histogram_add(stats_.lbd_histogram, lbd));
+            if (restart_policy_) {
+                restart_policy_->on_conflict(lbd, trail_.size());
+            }
+            
+            int backtrack_level = compute_backtrack_level(learnt_literals);
             backtrack(backtrack_level);
             
-            clauses_.push_back(learnt_clause);
-            attach_watch(learnt_clause, 0);
-            if (learnt_clause->literals.size() > 1) {
-                attach_watch(learnt_clause, 1);
+            // Learnt units become level-0 facts and need no storage
+            ClauseRef learnt_clause = kNoClause;
+            if (learnt_literals.size() == 2) {
+                add_binary(learnt_literals[0], learnt_literals[1]);
+                learnt_clause = binary_reason(learnt_literals[1]);
+            } else if (learnt_literals.size() > 2) {
+                learnt_clause = add_clause_to_arena(learnt_literals, true);
+                Clause& clause = ca_[learnt_clause];
+                clause.set_lbd(lbd);
+                clause.set_tier(lbd <= kCoreLbd ? Tier::Core
+                                : lbd <= kTier2Lbd ? Tier::Tier2 : Tier::Local);
+                bump_clause_activity(clause);
             }
             
-            uint32_t unit_var = learnt_clause->literals[0].var_id();
-            bool unit_value = learnt_clause->literals[0].is_positive();
-            if (!assign(unit_var, unit_value, backtrack_level, learnt_clause) ||
-                !propagate()) {
-                std::cout << "Conflict after learning - UNSAT\n";
+            uint32_t unit_var = learnt_literals[0].var_id();
+            bool unit_value = learnt_literals[0].is_positive();
+            assign(unit_var, unit_value, backtrack_level, learnt_clause);
+            decay_activities();
+            clause_inc_ /= clause_decay_;
+            continue;
+        }
+
+        if (interrupt_ && interrupt_->load(std::memory_order_relaxed)) {
+            interrupted_ = true;
+            backtrack(0);
+            return false;
+        }
+
+        if (restart_policy_ && restart_policy_->should_restart()) {
+            XOR_SMC_STAT(stats_.restarts++);
+            backtrack(0);
+            restart_policy_->on_restart();
+            continue;
+        }
+
+        if (num_conflicts_ >= next_reduce_) {
+            reduce_interval_ += 300;
+            next_reduce_ = num_conflicts_ + reduce_interval_;
+            reduce_db();
+        }
+
+        check_garbage();
+
+        // Pending assumptions are decided before any free variable
+        Literal next;
+        bool have_next = false;
+        while (static_cast<size_t>(decision_level_) < assumptions_.size()) {
+            const Literal& assumption = assumptions_[decision_level_];
+            if (is_true(assumption)) {
+                // Already implied: an empty level keeps levels and assumptions aligned
+                decision_level_++;
+            } else if (is_false(assumption)) {
+                XOR_SMC_DEBUG("Assumption contradicted - UNSAT");
+                analyze_final(assumption);
+                backtrack(0);
                 return false;
+            } else {
+                next = assumption;
+                have_next = true;
+                break;
+            }
+        }
+
+        if (!have_next) {
+            // Most active unassigned variable, in its saved phase
+            int next_var = pick_branch_var();
+
+            // No unassigned variables - SAT
+            if (next_var == -1) {
+                XOR_SMC_DEBUG("All variables assigned - SAT");
+                model_.resize(assignments_.size());
+                for (uint32_t var = 0; var < assignments_.size(); var++) {
+                    model_[var] = assignments_[var].value;
+                }
+                preprocessor_.extend_model(model_);
+                backtrack(0);
+                return true;
             }
+            next = Literal(next_var, polarity_[next_var]);
         }
+
+        // Make decision
+        XOR_SMC_STAT(stats_.decisions++);
+        decision_level_++;
+        assign(next.var_id(), next.is_positive(), decision_level_, kNoClause);
     }
 }
 
+void Solver::set_xor_chunk_width(uint32_t width) {
+    assert(width >= 3 && width <= 5);
+    xor_chunk_width_ = width;
+}
+
 void Solver::convert_xor_to_cnf(
     const std::vector<Literal>& xor_lits,
     std::vector<std::vector<Literal>>& cnf_clauses
 ) {
-    size_t n = xor_lits.size();
-    if (n == 0) return;
-    
-    // (XOR is 1 when odd number of variables are 1)
-    for(size_t mask = 0; mask < (1u << n); mask++) {
-        // Count number of 1s in this assignment
-        int ones = __builtin_popcount(mask);
-        
-        // If even number of 1s (wrong parity), add clause to forbid this assignment
-        if(ones % 2 == 0) {
-            std::vector<Literal> clause;
-            for(size_t j = 0; j < n; j++) {
-                bool val = (mask >> j) & 1;
-                // If val is 1, we want NOT x_j in the clause
-                // If val is 0, we want x_j in the clause
-                clause.push_back(Literal(
-                    xor_lits[j].var_id(),
-                    val != xor_lits[j].is_positive()
-                ));
-            }
-            cnf_clauses.push_back(clause);
+    encode_xor(normalize_xor(xor_lits), cnf_clauses, nullptr);
+}
+
+void Solver::encode_xor(const XorConstraint& constraint, std::vector<std::vector<Literal>>& cnf_clauses,
+                        std::vector<uint32_t>* internal_aux) {
+    // Chain of chunks: t1 = x1 ⊕ ... ⊕ x(w-1), t2 = t1 ⊕ ... and the last
+    // chunk carries the right-hand side
+    const auto& vars = constraint.vars;
+    std::vector<uint32_t> chunk;
+    size_t i = 0;
+    while (chunk.size() + (vars.size() - i) > xor_chunk_width_) {
+        while (chunk.size() < xor_chunk_width_ - 1) {
+            chunk.push_back(vars[i++]);
+        }
+        uint32_t link;
+        if (internal_aux) {
+            link = new_internal_var();
+            internal_aux->push_back(link);
+        } else {
+            link = new_var();
         }
+        chunk.push_back(link);
+        expand_xor_chunk(chunk, false, cnf_clauses);
+        chunk.assign(1, link);
     }
+    chunk.insert(chunk.end(), vars.begin() + i, vars.end());
+    expand_xor_chunk(chunk, constraint.rhs, cnf_clauses);
 }
 
-bool Solver::solve_smc(
-    const std::vector<uint32_t>& thresholds,
-    const std::vector<std::vector<uint32_t>>& counting_variables,
-    const std::vector<std::vector<uint32_t>>& fixed_variables,
-    int num_xor_tries,
-    double confidence
-) {
-    const int NUM_TRIALS = 10;
-
-    for(size_t i = 0; i < thresholds.size(); i++) {
-        int q = (thresholds[i] <= 1) ? 0 : std::ceil(std::log2(thresholds[i]));
-        int successes = 0;
-        
-        std::cout << "\nTesting threshold " << thresholds[i] << " using " 
-                  << q << " XORs\n";
-        
-        for(int trial = 0; trial < NUM_TRIALS; trial++) {
-            Solver test_solver;  
-            test_solver.set_num_variables(num_variables());
-            
-            for(const auto& clause : clauses_) {
-                test_solver.add_clause(clause->literals);
-            }
-            
-            // Add q random XOR constraints
-            for(int j = 0; j < q; j++) {
-                std::vector<Literal> xor_lits;
-                std::bernoulli_distribution d(0.5);
-                
-                // Add each variable with 50% probability
-                for(uint32_t var : counting_variables[i]) {
-                    if(d(rng_)) {
-                        xor_lits.push_back(Literal(var, d(rng_)));  // Random polarity
-                    }
-                }
-                
-                if(!xor_lits.empty()) {
-                    // Add random parity requirement
-                    if(d(rng_)) {
-                        xor_lits[0] = Literal(xor_lits[0].var_id(), !xor_lits[0].is_positive());
-                    }
-                    
-                    // Convert XOR to CNF and add clauses
-                    std::vector<std::vector<Literal>> cnf_clauses;
-                    convert_xor_to_cnf(xor_lits, cnf_clauses);
-                    for(const auto& clause : cnf_clauses) {
-                        test_solver.add_clause(clause);
-                    }
-                }
+void Solver::expand_xor_chunk(const std::vector<uint32_t>& vars, bool rhs,
+                              std::vector<std::vector<Literal>>& cnf_clauses) {
+    // One clause forbids each assignment of the wrong parity
+    size_t n = vars.size();
+    for (uint32_t mask = 0; mask < (1u << n); mask++) {
+        if ((__builtin_popcount(mask) & 1) == rhs) {
+            continue;
+        }
+        std::vector<Literal> clause;
+        for (size_t j = 0; j < n; j++) {
+            bool val = (mask >> j) & 1;
+            clause.push_back(Literal(vars[j], !val));
+        }
+        cnf_clauses.push_back(clause);
+    }
+}
+
+Formula Solver::snapshot() const {
+    Formula formula;
+    formula.set_num_variables(num_variables());
+    if (!ok_) {
+        formula.add_clause(nullptr, 0);
+        return formula;
+    }
+
+    size_t num_literals = trail_.size() + 2 * num_binary_;
+    for (ClauseRef cref : clauses_) {
+        num_literals += ca_[cref].size();
+    }
+    formula.reserve(trail_.size() + num_binary_ + clauses_.size(), num_literals);
+    for (uint32_t var : trail_) {
+        Literal unit(var, assignments_[var].value);
+        formula.add_clause(&unit, 1);
+    }
+    for (uint32_t index = 0; index < binary_watches_.size(); index++) {
+        for (const Literal& other : binary_watches_[index]) {
+            if (index < watch_index(other)) {
+                Literal binary[2] = {literal_at(index), other};
+                formula.add_clause(binary, 2);
             }
-            
-            bool is_sat = test_solver.solve();
-            if(is_sat) {
-                successes++;
-                std::cout << "Trial " << trial << ": SAT\n";
-            } else {
-                std::cout << "Trial " << trial << ": UNSAT\n";
+        }
+    }
+    for (ClauseRef cref : clauses_) {
+        formula.add_clause(ca_[cref].begin(), ca_[cref].size());
+    }
+    formula.xors_ = xor_engine_.constraints();
+    return formula;
+}
+
+void Solver::copy_problem_to(Solver& to, Formula base) const {
+    to.native_xor_ = native_xor_;
+    to.xor_chunk_width_ = xor_chunk_width_;
+    to.add_formula(std::move(base));
+}
+
+Formula Solver::simplified_snapshot(const std::vector<uint32_t>& frozen, PreprocessStats& stats) const {
+    Formula formula = snapshot();
+    Preprocessor preprocessor;
+    preprocessor.run(formula, frozen);
+    stats = preprocessor.stats();
+    XOR_SMC_INFO("Preprocessing: " << stats.clauses_before << " clauses down to " << stats.clauses_after
+                 << ", " << stats.eliminated_vars << " variables eliminated, " << stats.substituted_vars
+                 << " substituted, " << stats.units << " units");
+    return formula;
+}
+
+bool Solver::preprocess(const std::vector<uint32_t>& frozen, const PreprocessOptions& options) {
+    // Group clauses only hold under their activation variables, which
+    // elimination would not respect
+    assert(std::all_of(groups_.begin(), groups_.end(), [](const Group& g) { return g.released; }));
+    if (!ok_) {
+        return false;
+    }
+    std::vector<uint32_t> kept(frozen);
+    for (uint32_t var = 0; var < num_variables(); var++) {
+        if (is_internal_[var]) {
+            kept.push_back(var);
+        }
+    }
+
+    // Clauses and XORs come back with equivalent variables substituted;
+    // the XOR engine is rebuilt by the next solve
+    Formula formula = snapshot();
+    preprocessor_.run(formula, kept, options);
+    clear_clauses();
+    xor_engine_.clear();
+    add_formula(std::move(formula));
+    XOR_SMC_INFO("Preprocessing: " << num_clauses() << " clauses, "
+                 << preprocessor_.stats().eliminated_vars << " variables eliminated");
+    return ok_;
+}
+
+void Solver::copy_guarded_to(Solver& to, const std::vector<uint32_t>& var_map, uint32_t selector) const {
+    auto rename = [&](const Literal& lit) { return Literal(var_map[lit.var_id()], lit.is_positive()); };
+    const Literal unselected(selector, false);
+    if (!ok_) {
+        to.add_clause({unselected});
+        return;
+    }
+    for (uint32_t var : trail_) {
+        to.add_clause({rename(Literal(var, assignments_[var].value)), unselected});
+    }
+    for (uint32_t index = 0; index < binary_watches_.size(); index++) {
+        for (const Literal& other : binary_watches_[index]) {
+            if (index < watch_index(other)) {
+                to.add_clause({rename(literal_at(index)), rename(other), unselected});
             }
         }
-        
-        std::cout << "Had " << successes << " successes out of " << NUM_TRIALS << " trials\n";
-        
-        if(successes <= NUM_TRIALS/2) {
-            return false;
+    }
+    for (ClauseRef cref : clauses_) {
+        std::vector<Literal> clause;
+        for (const Literal& lit : ca_[cref]) {
+            clause.push_back(rename(lit));
         }
+        clause.push_back(unselected);
+        to.add_clause(clause);
+    }
+
+    // x1 ⊕ ... ⊕ xn ⊕ y with its own y, forced false by the selector
+    for (const auto& constraint : xor_engine_.constraints()) {
+        uint32_t guard = to.new_var();
+        std::vector<Literal> xor_lits;
+        for (uint32_t var : constraint.vars) {
+            xor_lits.push_back(Literal(var_map[var], true));
+        }
+        xor_lits.push_back(Literal(guard, constraint.rhs));
+        to.add_xor(xor_lits);
+        to.add_clause({Literal(guard, false), unselected});
     }
-    
-    return true;
 }
 
 std::vector<bool> Solver::get_model() const {
-    std::vector<bool> model(num_variables());
-    for (uint32_t i = 0; i < num_variables(); i++) {
-        assert(assignments_[i].level != -1);  
-        model[i] = assignments_[i].value;
-    }
-    return model;
+    return model_;
 }
 
 void Solver::add_blocking_clause(const std::vector<bool>& model) {
@@ -430,38 +1404,96 @@ void Solver::add_blocking_clause(const std::vector<bool>& model) {
     add_clause(blocking);
 }
 
+void Solver::add_blocking_clause(const std::vector<bool>& model, const std::vector<uint32_t>& projection) {
+    std::vector<Literal> blocking;
+    for (uint32_t var : projection) {
+        blocking.push_back(Literal(var, !model[var]));
+    }
+    add_clause(blocking);
+}
+
+void Solver::check_garbage() {
+    XOR_SMC_STAT(stats_.peak_clause_bytes =
+                     std::max(stats_.peak_clause_bytes, ca_.size() * sizeof(uint32_t)));
+    if (ca_.wasted() > ca_.size() / 5) {
+        garbage_collect();
+    }
+}
+
+void Solver::garbage_collect() {
+    ScopedTimer timer(stats_.garbage_collect_seconds);
+    ClauseAllocator to;
+    to.reserve(ca_.size() - ca_.wasted());
+
+    // Watches and reasons first, so clauses keep their relative order
+    for (auto& watch_list : watches_) {
+        for (auto& watcher : watch_list) {
+            ca_.reloc(watcher.cref, to);
+        }
+    }
+    for (uint32_t var : trail_) {
+        ClauseRef& reason = assignments_[var].reason;
+        if (is_arena_reason(reason)) {
+            ca_.reloc(reason, to);
+        }
+    }
+    for (auto& cref : clauses_) {
+        ca_.reloc(cref, to);
+    }
+    for (auto& cref : learnts_) {
+        ca_.reloc(cref, to);
+    }
+
+    ca_ = std::move(to);
+}
+
 uint32_t Solver::num_variables() const {
     return assignments_.size();
 }
 
+SolverStats Solver::stats() const {
+    SolverStats stats = stats_;
+    stats.xor_stats = xor_engine_.stats();
+    stats.peak_clause_bytes = std::max(stats.peak_clause_bytes, ca_.size() * sizeof(uint32_t));
+    return stats;
+}
+
+void Solver::reset_stats() {
+    stats_ = {};
+    xor_engine_.reset_stats();
+}
+
 uint32_t Solver::num_clauses() const {
-    return clauses_.size();
+    return clauses_.size() + num_binary_;
 }
 
-void Solver::print_clause(const std::shared_ptr<Clause>& clause) const {
-    std::cout << "(";
-    for (size_t i = 0; i < clause->literals.size(); i++) {
-        if (i > 0) std::cout << " ∨ ";
-        const auto& lit = clause->literals[i];
-        std::cout << (lit.is_positive() ? "" : "¬") << "x" << lit.var_id();
+void Solver::print_clause(ClauseRef cref) const {
+    const Clause& clause = ca_[cref];
+    std::ostringstream out;
+    out << "(";
+    for (size_t i = 0; i < clause.size(); i++) {
+        if (i > 0) out << " ∨ ";
+        const auto& lit = clause[i];
+        out << (lit.is_positive() ? "" : "¬") << "x" << lit.var_id();
     }
-    std::cout << ")";
+    out << ")";
+    XOR_SMC_TRACE(out.str());
 }
 
 void Solver::print_assignment() const {
+    std::ostringstream out;
     for (size_t i = 0; i < assignments_.size(); i++) {
         if (assignments_[i].level != -1) {
-            std::cout << "x" << i << "=" << assignments_[i].value 
-                     << "@" << assignments_[i].level << " ";
+            out << "x" << i << "=" << assignments_[i].value
+                << "@" << assignments_[i].level << " ";
         }
     }
-    std::cout << "\n";
+    XOR_SMC_TRACE(out.str());
 }
 
 bool Solver::get_value(uint32_t var_id) const {
-    assert(var_id < assignments_.size());
-    assert(assignments_[var_id].level != -1);  
-    return assignments_[var_id].value;
+    assert(var_id < model_.size());
+    return model_[var_id];
 }
 
 void Solver::add_unit_clause(const Literal& lit) {
@@ -0,0 +1,34 @@
+#include "xor_smc/Stats.hpp"
+#include <algorithm>
+
+namespace xor_smc {
+
+SolverStats& SolverStats::operator+=(const SolverStats& other) {
+    solves += other.solves;
+    decisions += other.decisions;
+    propagations += other.propagations;
+    conflicts += other.conflicts;
+    restarts += other.restarts;
+    reductions += other.reductions;
+    watch_visits += other.watch_visits;
+    binary_watch_visits += other.binary_watch_visits;
+    learnt_literals += other.learnt_literals;
+    for (size_t i = 0; i < kHistogramBins; i++) {
+        learnt_size_histogram[i] += other.learnt_size_histogram[i];
+        lbd_histogram[i] += other.lbd_histogram[i];
+    }
+    xor_stats.builds += other.xor_stats.builds;
+    xor_stats.row_additions += other.xor_stats.row_additions;
+    xor_stats.pivots += other.xor_stats.pivots;
+    xor_stats.implications += other.xor_stats.implications;
+    xor_stats.conflicts += other.xor_stats.conflicts;
+    solve_seconds += other.solve_seconds;
+    analyze_seconds += other.analyze_seconds;
+    reduce_seconds += other.reduce_seconds;
+    garbage_collect_seconds += other.garbage_collect_seconds;
+    xor_build_seconds += other.xor_build_seconds;
+    peak_clause_bytes = std::max(peak_clause_bytes, other.peak_clause_bytes);
+    return *this;
+}
+
+}
@@ -0,0 +1,92 @@
+#include "xor_smc/ThreadPool.hpp"
+#include <algorithm>
+
+namespace xor_smc {
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        threads_.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    unsigned index;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        index = next_queue_++ % queues_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+        pending_++;
+    }
+    work_cv_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void ThreadPool::run(unsigned worker) {
+    while (true) {
+        {
+            // Claiming a task first guarantees some deque still holds one
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+            if (queued_ == 0) {
+                return;
+            }
+            queued_--;
+        }
+
+        Task task;
+        while (!take(worker, task)) {
+            std::this_thread::yield();
+        }
+        task(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) {
+            done_cv_.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::take(unsigned worker, Task& task) {
+    // Own deque first, then steal from the others, always the oldest task
+    for (size_t k = 0; k < queues_.size(); k++) {
+        Queue& queue = *queues_[(worker + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+}
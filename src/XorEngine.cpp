@@ -0,0 +1,290 @@
+#include "xor_smc/XorEngine.hpp"
+#include <algorithm>
+
+namespace xor_smc {
+
+void XorEngine::add(const XorConstraint& constraint) {
+    constraints_.push_back(constraint);
+    needs_build_ = true;
+}
+
+void XorEngine::clear() {
+    constraints_.clear();
+    num_rows_ = 0;
+    num_cols_ = 0;
+    rows_.clear();
+    col_of_var_.clear();
+    col_rows_.clear();
+    worklist_.clear();
+    unassigned_cols_.clear();
+    needs_build_ = false;
+    dirty_ = false;
+}
+
+void XorEngine::remove_containing(const std::vector<uint32_t>& vars) {
+    auto mentions = [&vars](const XorConstraint& constraint) {
+        for (uint32_t var : constraint.vars) {
+            if (std::find(vars.begin(), vars.end(), var) != vars.end()) return true;
+        }
+        return false;
+    };
+    size_t before = constraints_.size();
+    constraints_.erase(std::remove_if(constraints_.begin(), constraints_.end(), mentions),
+                       constraints_.end());
+    if (constraints_.size() != before) needs_build_ = true;
+}
+
+bool XorEngine::build(uint32_t num_vars) {
+    XOR_SMC_STAT(stats_.builds++);
+    needs_build_ = false;
+    dirty_ = true;
+    implications_.clear();
+    reason_lits_.clear();
+
+    col_of_var_.assign(num_vars, kNone);
+    var_of_col_.clear();
+    for (const auto& constraint : constraints_) {
+        for (uint32_t var : constraint.vars) {
+            if (col_of_var_[var] == kNone) {
+                col_of_var_[var] = var_of_col_.size();
+                var_of_col_.push_back(var);
+            }
+        }
+    }
+    num_cols_ = var_of_col_.size();
+    words_ = (num_cols_ + 63) / 64;
+
+    uint32_t n = constraints_.size();
+    rows_.assign(static_cast<size_t>(n) * words_, 0);
+    rhs_.assign(n, 0);
+    for (uint32_t r = 0; r < n; r++) {
+        for (uint32_t var : constraints_[r].vars) {
+            uint32_t col = col_of_var_[var];
+            row(r)[col >> 6] ^= uint64_t(1) << (col & 63);
+        }
+        rhs_[r] = constraints_[r].rhs;
+    }
+
+    // Gauss-Jordan elimination
+    basic_col_.assign(n, kNone);
+    uint32_t rank = 0;
+    for (uint32_t col = 0; col < num_cols_ && rank < n; col++) {
+        uint32_t r = rank;
+        while (r < n && !has_col(r, col)) r++;
+        if (r == n) continue;
+
+        if (r != rank) {
+            std::swap_ranges(row(r), row(r) + words_, row(rank));
+            std::swap(rhs_[r], rhs_[rank]);
+        }
+        for (uint32_t k = 0; k < n; k++) {
+            if (k != rank && has_col(k, col)) {
+                XOR_SMC_STAT(stats_.row_additions++);
+                for (uint32_t w = 0; w < words_; w++) row(k)[w] ^= row(rank)[w];
+                rhs_[k] ^= rhs_[rank];
+            }
+        }
+        basic_col_[rank] = col;
+        rank++;
+    }
+
+    // Remaining rows are all-zero: 0 = 1 makes the system inconsistent
+    bool consistent = true;
+    for (uint32_t r = rank; r < n; r++) {
+        if (rhs_[r]) consistent = false;
+    }
+
+    num_rows_ = rank;
+    rows_.resize(static_cast<size_t>(rank) * words_);
+    rhs_.resize(rank);
+    basic_col_.resize(rank);
+    row_of_basic_.assign(num_cols_, kNone);
+    for (uint32_t r = 0; r < rank; r++) {
+        row_of_basic_[basic_col_[r]] = r;
+    }
+
+    col_rows_.assign(num_cols_, {});
+    for (uint32_t r = 0; r < rank; r++) {
+        for (uint32_t w = 0; w < words_; w++) {
+            for (uint64_t m = row(r)[w]; m; m &= m - 1) {
+                col_rows_[w * 64 + __builtin_ctzll(m)].push_back(r);
+            }
+        }
+    }
+    row_stamp_.assign(rank, 0);
+    stamp_ = 0;
+
+    // Every row is checked on the first recheck()
+    assigned_.assign(words_, 0);
+    values_.assign(words_, 0);
+    in_worklist_.assign(rank, 1);
+    worklist_.clear();
+    for (uint32_t r = 0; r < rank; r++) worklist_.push_back(r);
+    unassigned_cols_.clear();
+    return consistent;
+}
+
+bool XorEngine::assign(uint32_t var, bool value) {
+    if (var >= col_of_var_.size() || col_of_var_[var] == kNone) return true;
+    uint32_t col = col_of_var_[var];
+    uint64_t bit = uint64_t(1) << (col & 63);
+    assigned_[col >> 6] |= bit;
+    if (value) values_[col >> 6] |= bit;
+
+    if (dirty_) push_unassigned();
+    push_rows_of(col);
+    return process_worklist();
+}
+
+void XorEngine::unassign(uint32_t var) {
+    if (var >= col_of_var_.size() || col_of_var_[var] == kNone) return;
+    uint32_t col = col_of_var_[var];
+    uint64_t mask = ~(uint64_t(1) << (col & 63));
+    assigned_[col >> 6] &= mask;
+    values_[col >> 6] &= mask;
+    unassigned_cols_.push_back(col);
+    dirty_ = true;
+}
+
+bool XorEngine::recheck() {
+    push_unassigned();
+    return process_worklist();
+}
+
+void XorEngine::push_unassigned() {
+    dirty_ = false;
+    for (uint32_t col : unassigned_cols_) push_rows_of(col);
+    unassigned_cols_.clear();
+}
+
+void XorEngine::clear_implications() {
+    implications_.clear();
+    reason_lits_.clear();
+}
+
+void XorEngine::push_row(uint32_t r) {
+    if (!in_worklist_[r]) {
+        in_worklist_[r] = 1;
+        worklist_.push_back(r);
+    }
+}
+
+void XorEngine::push_rows_of(uint32_t col) {
+    if (++stamp_ == 0) {
+        std::fill(row_stamp_.begin(), row_stamp_.end(), 0);
+        stamp_ = 1;
+    }
+    auto& rows = col_rows_[col];
+    size_t j = 0;
+    for (uint32_t r : rows) {
+        if (row_stamp_[r] != stamp_ && has_col(r, col)) {
+            row_stamp_[r] = stamp_;
+            rows[j++] = r;
+            push_row(r);
+        }
+    }
+    rows.resize(j);
+}
+
+bool XorEngine::process_worklist() {
+    while (!worklist_.empty()) {
+        uint32_t r = worklist_.back();
+        worklist_.pop_back();
+        in_worklist_[r] = 0;
+
+        // Rows still queued are checked after backtracking
+        if (!check_row(r)) {
+            dirty_ = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+void XorEngine::pivot(uint32_t r, uint32_t col) {
+    XOR_SMC_STAT(stats_.pivots++);
+    int32_t old = basic_col_[r];
+    if (old != kNone) row_of_basic_[old] = kNone;
+    basic_col_[r] = col;
+    row_of_basic_[col] = r;
+
+    // Eliminate the new basic column from every other row; the columns a
+    // row gains list it
+    const uint64_t* src = row(r);
+    for (uint32_t k : col_rows_[col]) {
+        if (k == r || !has_col(k, col)) continue;
+        XOR_SMC_STAT(stats_.row_additions++);
+        uint64_t* dst = row(k);
+        for (uint32_t w = 0; w < words_; w++) {
+            for (uint64_t m = src[w] & ~dst[w]; m; m &= m - 1) {
+                col_rows_[w * 64 + __builtin_ctzll(m)].push_back(k);
+            }
+            dst[w] ^= src[w];
+        }
+        rhs_[k] ^= rhs_[r];
+        push_row(k);
+    }
+    col_rows_[col].assign(1, r);
+}
+
+bool XorEngine::check_row(uint32_t r) {
+    const uint64_t* rw = row(r);
+    int unassigned = 0;
+    int32_t first = kNone;
+    uint32_t parity = 0;
+
+    for (uint32_t w = 0; w < words_; w++) {
+        parity ^= __builtin_popcountll(rw[w] & values_[w]);
+        uint64_t free_bits = rw[w] & ~assigned_[w];
+        if (free_bits && unassigned < 2) {
+            if (first == kNone) first = w * 64 + __builtin_ctzll(free_bits);
+            unassigned += __builtin_popcountll(free_bits) > 1 ? 2 : 1;
+        }
+    }
+    bool assigned_parity = parity & 1;
+
+    if (unassigned == 0) {
+        if (assigned_parity == static_cast<bool>(rhs_[r])) return true;
+        XOR_SMC_STAT(stats_.conflicts++);
+        conflict_.clear();
+        for (uint32_t w = 0; w < words_; w++) {
+            for (uint64_t m = rw[w]; m; m &= m - 1) {
+                uint32_t col = w * 64 + __builtin_ctzll(m);
+                bool value = (values_[col >> 6] >> (col & 63)) & 1;
+                conflict_.push_back(Literal(var_of_col_[col], !value));
+            }
+        }
+        return false;
+    }
+
+    if (unassigned == 1) {
+        if (basic_col_[r] != first) pivot(r, first);
+        explain_row(r, first, assigned_parity != static_cast<bool>(rhs_[r]));
+        return true;
+    }
+
+    // Keep the basic column unassigned while the row is still open
+    if (col_assigned(basic_col_[r])) pivot(r, first);
+    return true;
+}
+
+void XorEngine::explain_row(uint32_t r, int32_t implied_col, bool implied_value) {
+    Implication imp{Literal(var_of_col_[implied_col], implied_value),
+                    static_cast<uint32_t>(reason_lits_.size()), 0};
+    reason_lits_.push_back(imp.lit);
+
+    const uint64_t* rw = row(r);
+    for (uint32_t w = 0; w < words_; w++) {
+        for (uint64_t m = rw[w]; m; m &= m - 1) {
+            uint32_t col = w * 64 + __builtin_ctzll(m);
+            if (static_cast<int32_t>(col) == implied_col) continue;
+            bool value = (values_[col >> 6] >> (col & 63)) & 1;
+            reason_lits_.push_back(Literal(var_of_col_[col], !value));
+        }
+    }
+    imp.reason_size = reason_lits_.size() - imp.reason_begin;
+    implications_.push_back(imp);
+    XOR_SMC_STAT(stats_.implications++);
+}
+
+}
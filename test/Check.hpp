@@ -0,0 +1,94 @@
+#pragma once
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A minimal test harness: TEST(name) { ... } registers a test case, CHECK
+// records a failure and carries on, REQUIRE stops the case. run_tests
+// runs every case whose name contains one of the arguments, or all of
+// them, and returns the process exit code.
+
+namespace xor_smc {
+namespace test {
+
+struct TestCase {
+    const char* name;
+    std::function<void()> run;
+};
+
+inline std::vector<TestCase>& test_cases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& failure_count() {
+    static int failures = 0;
+    return failures;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> run) { test_cases().push_back({name, std::move(run)}); }
+};
+
+// Thrown by REQUIRE to leave the current case
+struct Abort {};
+
+inline bool check(bool passed, const char* expression, const char* file, int line, const std::string& detail) {
+    if (!passed) {
+        failure_count()++;
+        std::cerr << file << ":" << line << ": CHECK(" << expression << ") failed" << detail << "\n";
+    }
+    return passed;
+}
+
+inline int run_tests(int argc, char** argv) {
+    int run = 0;
+    for (const TestCase& test : test_cases()) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            selected |= std::strstr(test.name, argv[i]) != nullptr;
+        }
+        if (!selected) {
+            continue;
+        }
+        int failures_before = failure_count();
+        try {
+            test.run();
+        } catch (const Abort&) {
+        }
+        run++;
+        std::cerr << (failure_count() == failures_before ? "[ ok ] " : "[FAIL] ") << test.name << "\n";
+    }
+    std::cerr << run << " tests, " << failure_count() << " failed checks\n";
+    return failure_count() == 0 && run > 0 ? 0 : 1;
+}
+
+}
+}
+
+#define XOR_SMC_TEST_CONCAT_(a, b) a##b
+#define XOR_SMC_TEST_CONCAT(a, b) XOR_SMC_TEST_CONCAT_(a, b)
+
+#define TEST(name)                                                                          \
+    static void name();                                                                     \
+    static ::xor_smc::test::Registrar XOR_SMC_TEST_CONCAT(name, _registrar)(#name, name);   \
+    static void name()
+
+#define CHECK(condition) ::xor_smc::test::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__, "")
+
+// Also prints both sides
+#define CHECK_EQ(a, b)                                                                      \
+    do {                                                                                    \
+        const auto& xor_smc_check_a_ = (a);                                                 \
+        const auto& xor_smc_check_b_ = (b);                                                 \
+        ::xor_smc::test::check(xor_smc_check_a_ == xor_smc_check_b_, #a " == " #b, __FILE__, \
+                               __LINE__, ": " + std::to_string(xor_smc_check_a_) + " != " + \
+                                   std::to_string(xor_smc_check_b_));                       \
+    } while (0)
+
+#define REQUIRE(condition)                                                                  \
+    do {                                                                                    \
+        if (!CHECK(condition)) throw ::xor_smc::test::Abort();                              \
+    } while (0)
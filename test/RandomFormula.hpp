@@ -0,0 +1,164 @@
+#pragma once
+#include "xor_smc/Formula.hpp"
+#include "xor_smc/Solver.hpp"
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace xor_smc {
+namespace test {
+
+// A formula over at most 20 variables, small enough to check by
+// enumerating every assignment. Clauses may repeat literals or be
+// tautologies; an XOR of literals is true.
+struct SmallFormula {
+    uint32_t num_vars = 0;
+    std::vector<std::vector<Literal>> clauses;
+    std::vector<std::vector<Literal>> xors;
+
+    // Bit i of the assignment is variable i
+    bool satisfied(uint32_t assignment) const {
+        auto value = [assignment](const Literal& lit) { return ((assignment >> lit.var_id()) & 1) == lit.is_positive(); };
+        for (const auto& clause : clauses) {
+            bool sat = false;
+            for (const Literal& lit : clause) {
+                sat |= value(lit);
+            }
+            if (!sat) {
+                return false;
+            }
+        }
+        for (const auto& xor_lits : xors) {
+            bool parity = false;
+            for (const Literal& lit : xor_lits) {
+                parity ^= value(lit);
+            }
+            if (!parity) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool satisfied(const std::vector<bool>& model) const {
+        uint32_t assignment = 0;
+        for (uint32_t var = 0; var < num_vars; var++) {
+            if (var < model.size() && model[var]) {
+                assignment |= 1u << var;
+            }
+        }
+        return satisfied(assignment);
+    }
+
+    // Models with every literal of the cube true
+    uint64_t count_models(const std::vector<Literal>& cube = {}) const {
+        uint64_t count = 0;
+        for (uint32_t assignment = 0; assignment < (1u << num_vars); assignment++) {
+            bool in_cube = true;
+            for (const Literal& lit : cube) {
+                in_cube &= ((assignment >> lit.var_id()) & 1) == lit.is_positive();
+            }
+            count += in_cube && satisfied(assignment);
+        }
+        return count;
+    }
+
+    // Distinct assignments to the projection that extend to a model
+    uint64_t count_projected(const std::vector<uint32_t>& projection) const {
+        std::vector<bool> seen(1u << projection.size());
+        uint64_t count = 0;
+        for (uint32_t assignment = 0; assignment < (1u << num_vars); assignment++) {
+            if (!satisfied(assignment)) {
+                continue;
+            }
+            uint32_t key = 0;
+            for (size_t i = 0; i < projection.size(); i++) {
+                key |= ((assignment >> projection[i]) & 1) << i;
+            }
+            count += !seen[key];
+            seen[key] = true;
+        }
+        return count;
+    }
+
+    void add_to(Solver& solver) const {
+        solver.set_num_variables(num_vars);
+        for (const auto& clause : clauses) {
+            solver.add_clause(clause);
+        }
+        for (const auto& xor_lits : xors) {
+            solver.add_xor(xor_lits);
+        }
+    }
+
+    Formula to_formula() const {
+        Formula formula;
+        formula.set_num_variables(num_vars);
+        for (const auto& clause : clauses) {
+            formula.add_clause(clause);
+        }
+        for (const auto& xor_lits : xors) {
+            formula.add_xor(xor_lits);
+        }
+        return formula;
+    }
+
+    // DIMACS with "x" lines, to replay a failure
+    std::string to_dimacs() const {
+        std::ostringstream out;
+        out << "p cnf " << num_vars << " " << clauses.size() + xors.size() << "\n";
+        auto write = [&out](const std::vector<Literal>& lits) {
+            for (const Literal& lit : lits) {
+                out << (lit.is_positive() ? "" : "-") << lit.var_id() + 1 << " ";
+            }
+            out << "0\n";
+        };
+        for (const auto& clause : clauses) {
+            write(clause);
+        }
+        for (const auto& xor_lits : xors) {
+            out << "x";
+            write(xor_lits);
+        }
+        return out.str();
+    }
+};
+
+inline Literal random_literal(std::mt19937_64& rng, uint32_t num_vars) {
+    return Literal(rng() % num_vars, rng() & 1);
+}
+
+// Between 1 and max_vars variables, clauses of 1 to 4 literals up to 5
+// per variable, and up to 3 XORs of random density; the mix lands on
+// both sides of satisfiability
+inline SmallFormula random_formula(std::mt19937_64& rng, uint32_t max_vars) {
+    SmallFormula formula;
+    formula.num_vars = 1 + rng() % max_vars;
+    uint32_t num_clauses = rng() % (5 * formula.num_vars);
+    for (uint32_t i = 0; i < num_clauses; i++) {
+        std::vector<Literal> clause(1 + rng() % 4);
+        for (Literal& lit : clause) {
+            lit = random_literal(rng, formula.num_vars);
+        }
+        formula.clauses.push_back(clause);
+    }
+    uint32_t num_xors = rng() % 4;
+    for (uint32_t i = 0; i < num_xors; i++) {
+        std::vector<Literal> xor_lits;
+        uint32_t density = 2 + rng() % 3;
+        for (uint32_t var = 0; var < formula.num_vars; var++) {
+            if (rng() % density == 0) {
+                xor_lits.push_back(Literal(var, rng() & 1));
+            }
+        }
+        if (!xor_lits.empty()) {
+            formula.xors.push_back(xor_lits);
+        }
+    }
+    return formula;
+}
+
+}
+}
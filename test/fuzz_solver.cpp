@@ -0,0 +1,184 @@
+#include "RandomFormula.hpp"
+#include "xor_smc/Solver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace xor_smc;
+using namespace xor_smc::test;
+
+// Cross-checks the solver against enumeration on random formulas, each
+// solved along a randomly chosen path: native or CNF-encoded XORs, clauses
+// added one by one, in bulk or through a Formula, under assumptions, with
+// part of the formula in a constraint group, or preprocessed with the
+// assumed variables kept. Stops at the first
+// disagreement and prints the formula as DIMACS with the options that
+// reproduce it.
+//
+//   fuzz_solver [--seed N] [--start N] [--iterations N] [--seconds S] [--max-vars N]
+
+namespace {
+
+struct Config {
+    uint64_t seed = 1;
+    uint64_t start = 0;  // First iteration
+    uint64_t iterations = 10000;
+    double seconds = 0;  // No time limit
+    uint32_t max_vars = 14;
+};
+
+// One way of handing the formula to the solver
+struct Path {
+    bool native_xor;
+    uint32_t chunk_width;
+    int load;  // 0 clause by clause, 1 bulk, 2 formula
+    bool grouped;  // The XORs and the second half of the clauses in a group
+    bool presolve;  // An extra solve before the assumptions
+    bool preprocessed;  // Unless grouped
+
+    std::string describe() const {
+        static const char* loads[] = {"clauses", "bulk", "formula"};
+        return std::string("native_xor=") + (native_xor ? "1" : "0") + " chunk_width=" + std::to_string(chunk_width) +
+               " load=" + loads[load] + " grouped=" + (grouped ? "1" : "0") + " presolve=" + (presolve ? "1" : "0") +
+               " preprocessed=" + (preprocessed && !grouped ? "1" : "0");
+    }
+};
+
+void load(Solver& solver, const SmallFormula& formula, const Path& path) {
+    solver.set_native_xor(path.native_xor);
+    solver.set_xor_chunk_width(path.chunk_width);
+    solver.set_num_variables(formula.num_vars);
+
+    size_t num_plain = path.grouped ? formula.clauses.size() / 2 : formula.clauses.size();
+    if (path.load == 2) {
+        SmallFormula plain = formula;
+        plain.clauses.resize(num_plain);
+        if (path.grouped) {
+            plain.xors.clear();
+        }
+        solver.add_formula(plain.to_formula());
+    } else if (path.load == 1) {
+        std::vector<Literal> literals;
+        std::vector<size_t> offsets{0};
+        for (size_t i = 0; i < num_plain; i++) {
+            literals.insert(literals.end(), formula.clauses[i].begin(), formula.clauses[i].end());
+            offsets.push_back(literals.size());
+        }
+        solver.add_clauses(literals.data(), offsets.data(), num_plain);
+    } else {
+        for (size_t i = 0; i < num_plain; i++) {
+            solver.add_clause(formula.clauses[i]);
+        }
+    }
+    if (path.load != 2 && !path.grouped) {
+        for (const auto& xor_lits : formula.xors) {
+            solver.add_xor(xor_lits);
+        }
+    }
+
+    if (path.grouped) {
+        uint32_t group = solver.new_group();
+        for (size_t i = num_plain; i < formula.clauses.size(); i++) {
+            solver.add_clause(formula.clauses[i], group);
+        }
+        for (const auto& xor_lits : formula.xors) {
+            solver.add_xor(xor_lits, group);
+        }
+    }
+}
+
+// Empty when the solver agrees with enumeration
+std::string run_case(const SmallFormula& formula, const Path& path, const std::vector<Literal>& assumptions,
+                     uint64_t seed) {
+    Solver solver;
+    solver.set_seed(seed);
+    load(solver, formula, path);
+    if (path.presolve && solver.solve() != (formula.count_models() > 0)) {
+        return "wrong answer without assumptions";
+    }
+    if (path.preprocessed && !path.grouped) {
+        std::vector<uint32_t> frozen;
+        for (const Literal& lit : assumptions) {
+            frozen.push_back(lit.var_id());
+        }
+        if (!solver.preprocess(frozen) && formula.count_models() > 0) {
+            return "preprocessing found a satisfiable formula UNSAT";
+        }
+    }
+
+    bool sat = solver.solve(assumptions);
+    if (sat != (formula.count_models(assumptions) > 0)) {
+        return sat ? "SAT, expected UNSAT" : "UNSAT, expected SAT";
+    }
+    if (sat) {
+        if (!formula.satisfied(solver.get_model())) {
+            return "model falsifies the formula";
+        }
+        for (const Literal& lit : assumptions) {
+            if (solver.get_value(lit.var_id()) != lit.is_positive()) {
+                return "model falsifies an assumption";
+            }
+        }
+    } else if (formula.count_models(solver.failed_assumptions()) > 0) {
+        return "failed assumptions are consistent with the formula";
+    }
+    return "";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--seed") && has_value) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--start") && has_value) {
+            config.start = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--iterations") && has_value) {
+            config.iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--seconds") && has_value) {
+            config.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-vars") && has_value) {
+            config.max_vars = std::min(20, std::max(1, std::atoi(argv[++i])));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--seed N] [--start N] [--iterations N] [--seconds S] [--max-vars N]\n";
+            return 2;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t iteration = config.start;
+    for (; iteration < config.start + config.iterations; iteration++) {
+        if (config.seconds > 0 &&
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > config.seconds) {
+            break;
+        }
+        // Every case is reproducible from the seed and its iteration alone
+        std::mt19937_64 rng(config.seed * 1000003 + iteration);
+        SmallFormula formula = random_formula(rng, config.max_vars);
+        Path path{rng() % 4 != 0, 3 + uint32_t(rng() % 3), int(rng() % 3), rng() % 3 == 0, rng() % 2 == 0,
+                  rng() % 3 == 0};
+        std::vector<Literal> assumptions(rng() % 4);
+        for (Literal& lit : assumptions) {
+            lit = random_literal(rng, formula.num_vars);
+        }
+
+        std::string error = run_case(formula, path, assumptions, iteration);
+        if (!error.empty()) {
+            std::cerr << "--seed " << config.seed << " --start " << iteration << " --iterations 1: " << error << "\n"
+                      << "c " << path.describe() << "\nc assumptions";
+            for (const Literal& lit : assumptions) {
+                std::cerr << " " << (lit.is_positive() ? "" : "-") << lit.var_id() + 1;
+            }
+            std::cerr << "\n" << formula.to_dimacs();
+            return 1;
+        }
+    }
+    std::cerr << iteration - config.start << " cases agree\n";
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "Check.hpp"
+#include "RandomFormula.hpp"
+#include "xor_smc/Preprocessor.hpp"
+#include "xor_smc/Solver.hpp"
+#include <algorithm>
+#include <random>
+
+using namespace xor_smc;
+using namespace xor_smc::test;
+
+namespace {
+
+SmallFormula from_formula(const Formula& formula) {
+    SmallFormula small;
+    small.num_vars = formula.num_variables();
+    if (formula.has_empty_clause()) {
+        small.clauses.push_back({});
+    }
+    for (size_t i = 0; i < formula.num_clauses(); i++) {
+        LiteralSpan clause = formula.clause(i);
+        small.clauses.emplace_back(clause.begin(), clause.end());
+    }
+    for (const XorConstraint& constraint : formula.xors()) {
+        std::vector<Literal> xor_lits;
+        for (uint32_t var : constraint.vars) {
+            xor_lits.push_back(Literal(var, true));
+        }
+        if (!constraint.rhs) {
+            xor_lits[0] = ~xor_lits[0];
+        }
+        small.xors.push_back(xor_lits);
+    }
+    return small;
+}
+
+// Each variable with probability 1/2
+std::vector<uint32_t> random_subset(std::mt19937_64& rng, uint32_t num_vars) {
+    std::vector<uint32_t> vars;
+    for (uint32_t var = 0; var < num_vars; var++) {
+        if (rng() & 1) {
+            vars.push_back(var);
+        }
+    }
+    return vars;
+}
+
+// Same models on the frozen variables, none of the removed variables left,
+// and every model of the simplified formula extends to one of the original
+void check_simplified(const SmallFormula& original, const SmallFormula& simplified,
+                      const Preprocessor& preprocessor, const std::vector<uint32_t>& frozen) {
+    CHECK_EQ(simplified.count_projected(frozen), original.count_projected(frozen));
+    for (uint32_t var : frozen) {
+        CHECK(!preprocessor.is_eliminated(var));
+    }
+    for (const auto* constraints : {&simplified.clauses, &simplified.xors}) {
+        for (const auto& lits : *constraints) {
+            for (const Literal& lit : lits) {
+                CHECK(!preprocessor.is_eliminated(lit.var_id()));
+            }
+        }
+    }
+
+    for (uint32_t assignment = 0; assignment < (1u << simplified.num_vars); assignment++) {
+        if (!simplified.satisfied(assignment)) {
+            continue;
+        }
+        std::vector<bool> model(original.num_vars);
+        for (uint32_t var = 0; var < original.num_vars; var++) {
+            model[var] = (assignment >> var) & 1;
+        }
+        preprocessor.extend_model(model);
+        CHECK(original.satisfied(model));
+    }
+}
+
+}
+
+TEST(simplified_formula_keeps_projected_models) {
+    std::mt19937_64 rng(21);
+    uint64_t eliminated = 0;
+    for (int i = 0; i < 2000; i++) {
+        SmallFormula original = random_formula(rng, 12);
+        std::vector<uint32_t> frozen = random_subset(rng, original.num_vars);
+
+        Formula formula = original.to_formula();
+        Preprocessor preprocessor;
+        bool sat = preprocessor.run(formula, frozen);
+        SmallFormula simplified = from_formula(formula);
+        if (!sat) {
+            CHECK_EQ(original.count_models(), 0u);
+        }
+
+        check_simplified(original, simplified, preprocessor, frozen);
+        eliminated += preprocessor.stats().eliminated_vars;
+    }
+#ifndef XOR_SMC_NO_STATS
+    CHECK(eliminated > 0);
+#endif
+}
+
+TEST(equivalences_are_substituted) {
+    std::mt19937_64 rng(24);
+    uint64_t substituted = 0;
+    for (int i = 0; i < 2000; i++) {
+        // Equivalences both as pairs of binary clauses and as XORs of two
+        // variables, often chained
+        SmallFormula original = random_formula(rng, 12);
+        for (int j = 0; j < 4; j++) {
+            Literal a = random_literal(rng, original.num_vars);
+            Literal b = random_literal(rng, original.num_vars);
+            if (rng() & 1) {
+                original.clauses.push_back({~a, b});
+                original.clauses.push_back({a, ~b});
+            } else {
+                original.xors.push_back({a, b});
+            }
+        }
+        std::vector<uint32_t> frozen = random_subset(rng, original.num_vars);
+
+        Formula formula = original.to_formula();
+        PreprocessOptions options;
+        options.subsume = false;
+        options.probe = false;
+        options.eliminate = false;
+        Preprocessor preprocessor;
+        bool sat = preprocessor.run(formula, frozen, options);
+        if (!sat) {
+            CHECK_EQ(original.count_models(), 0u);
+        }
+        check_simplified(original, from_formula(formula), preprocessor, frozen);
+        substituted += preprocessor.stats().substituted_vars;
+    }
+#ifndef XOR_SMC_NO_STATS
+    CHECK(substituted > 0);
+#endif
+}
+
+TEST(preprocessed_solver_matches_enumeration) {
+    std::mt19937_64 rng(22);
+    for (int i = 0; i < 1000; i++) {
+        SmallFormula formula = random_formula(rng, 12);
+        std::vector<uint32_t> frozen = random_subset(rng, formula.num_vars);
+
+        Solver solver;
+        solver.set_seed(i);
+        solver.set_native_xor(i % 4 != 0);
+        formula.add_to(solver);
+        bool sat = solver.preprocess(frozen);
+        CHECK(sat || formula.count_models() == 0);
+
+        for (int round = 0; round < 4; round++) {
+            // Assumptions and new clauses only over frozen variables
+            std::vector<Literal> assumptions;
+            for (uint32_t var : frozen) {
+                if (rng() % 3 == 0) {
+                    assumptions.push_back(Literal(var, rng() & 1));
+                }
+            }
+            if (round == 2 && frozen.size() >= 2) {
+                std::vector<Literal> clause{Literal(frozen[0], rng() & 1), Literal(frozen.back(), rng() & 1)};
+                solver.add_clause(clause);
+                formula.clauses.push_back(clause);
+            }
+            bool answer = solver.solve(assumptions);
+            CHECK_EQ(answer, formula.count_models(assumptions) > 0);
+            if (answer) {
+                CHECK(formula.satisfied(solver.get_model()));
+                for (const Literal& lit : assumptions) {
+                    CHECK_EQ(solver.get_value(lit.var_id()), lit.is_positive());
+                }
+            }
+        }
+    }
+}
+
+// Eliminated variables are existentially quantified, so with the counting
+// and fixed variables kept every trial has the same outcome either way
+TEST(preprocessing_keeps_seeded_smc_answers) {
+    std::mt19937_64 rng(23);
+    for (int i = 0; i < 60; i++) {
+        SmallFormula formula = random_formula(rng, 12);
+        std::vector<uint32_t> counting = random_subset(rng, formula.num_vars);
+        if (counting.empty()) {
+            continue;
+        }
+        std::vector<uint32_t> thresholds;
+        for (uint32_t q = 0; q <= counting.size(); q += 2) {
+            thresholds.push_back(1u << q);
+        }
+        std::vector<std::vector<uint32_t>> sets(thresholds.size(), counting);
+        std::vector<std::vector<uint32_t>> no_fixed(thresholds.size());
+        std::vector<std::vector<uint32_t>> fixed(1, {counting[0]});
+        std::vector<uint32_t> rest(counting.begin() + 1, counting.end());
+
+        bool verdicts[2];
+        bool joint[2];
+        std::vector<bool> sweeps[2];
+        double counts[2];
+        for (int run = 0; run < 2; run++) {
+            SmcOptions options;
+            options.preprocess = run == 1;
+            CountOptions count_options;
+            count_options.preprocess = run == 1;
+            Solver solver;
+            solver.set_seed(i);
+            formula.add_to(solver);
+            verdicts[run] = solver.solve_smc(thresholds, sets, no_fixed, options);
+            sweeps[run] = solver.solve_smc_sweep(thresholds, sets, options);
+            joint[run] = solver.solve_smc({2}, {rest}, fixed, options);
+            counts[run] = solver.count(counting, count_options).estimate();
+        }
+        CHECK_EQ(verdicts[0], verdicts[1]);
+        CHECK(sweeps[0] == sweeps[1]);
+        CHECK_EQ(joint[0], joint[1]);
+        CHECK_EQ(counts[0], counts[1]);
+    }
+}
+
+int main(int argc, char** argv) {
+    return run_tests(argc, argv);
+}
@@ -0,0 +1,405 @@
+#include "Check.hpp"
+#include "RandomFormula.hpp"
+#include "xor_smc/Solver.hpp"
+#include "xor_smc/ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace xor_smc;
+using namespace xor_smc::test;
+
+// SMC and counting are randomized: each verdict or estimate is only right
+// with high probability. The checks below count the wrong answers over
+// many random formulas and bound their rate, on thresholds at least a
+// factor 8 from the exact count, where a trial is SAT with probability
+// far from 1/2 either way.
+
+namespace {
+
+// Each variable with probability 3/4, at least one
+std::vector<uint32_t> random_projection(std::mt19937_64& rng, uint32_t num_vars) {
+    std::vector<uint32_t> projection;
+    for (uint32_t var = 0; var < num_vars; var++) {
+        if (rng() % 4 != 0) {
+            projection.push_back(var);
+        }
+    }
+    if (projection.empty()) {
+        projection.push_back(rng() % num_vars);
+    }
+    return projection;
+}
+
+// Expected verdict of "count >= 2^q": 1 pass, 0 fail, -1 too close to call
+int expected_verdict(uint64_t count, uint32_t q) {
+    if (count == 0) {
+        return 0;
+    }
+    double gap = std::log2(static_cast<double>(count)) - q;
+    return gap >= 3 ? 1 : gap <= -3 ? 0 : -1;
+}
+
+}
+
+TEST(smc_verdicts_match_exact_counts) {
+    std::mt19937_64 rng(11);
+    int cases = 0;
+    int wrong = 0;
+    for (int i = 0; i < 150; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+        std::vector<uint32_t> projection = random_projection(rng, formula.num_vars);
+        uint64_t count = formula.count_projected(projection);
+        for (uint32_t q = 0; q <= projection.size() + 3; q++) {
+            int expected = expected_verdict(count, q);
+            if (expected < 0) {
+                continue;
+            }
+            Solver solver;
+            solver.set_seed(i * 100 + q);
+            formula.add_to(solver);
+            bool verdict = solver.solve_smc({1u << q}, {projection}, {{}}, SmcOptions());
+            cases++;
+            wrong += verdict != bool(expected);
+        }
+    }
+    CHECK(cases > 500);
+    CHECK(wrong * 100 <= cases);
+}
+
+TEST(sweep_verdicts_match_exact_counts) {
+    std::mt19937_64 rng(12);
+    int cases = 0;
+    int wrong = 0;
+    for (int i = 0; i < 150; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+        std::vector<uint32_t> projection = random_projection(rng, formula.num_vars);
+        uint64_t count = formula.count_projected(projection);
+
+        std::vector<uint32_t> thresholds;
+        for (uint32_t q = 0; q <= projection.size() + 3; q++) {
+            thresholds.push_back(1u << q);
+        }
+        Solver solver;
+        solver.set_seed(i);
+        formula.add_to(solver);
+        std::vector<bool> verdicts =
+            solver.solve_smc_sweep(thresholds, std::vector<std::vector<uint32_t>>(thresholds.size(), projection));
+        REQUIRE(verdicts.size() == thresholds.size());
+        for (uint32_t q = 0; q < thresholds.size(); q++) {
+            int expected = expected_verdict(count, q);
+            if (expected >= 0) {
+                cases++;
+                wrong += verdicts[q] != bool(expected);
+            }
+            // Nested hashes make the verdicts monotone in the threshold
+            if (q > 0) {
+                CHECK(verdicts[q - 1] || !verdicts[q]);
+            }
+        }
+    }
+    CHECK(cases > 500);
+    CHECK(wrong * 100 <= cases);
+}
+
+TEST(seeded_verdicts_do_not_depend_on_threads) {
+    std::mt19937_64 rng(13);
+    for (int i = 0; i < 40; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+        std::vector<uint32_t> projection = random_projection(rng, formula.num_vars);
+        std::vector<uint32_t> thresholds;
+        for (uint32_t q = 0; q <= projection.size(); q += 2) {
+            thresholds.push_back(1u << q);
+        }
+        std::vector<std::vector<uint32_t>> counting(thresholds.size(), projection);
+        std::vector<std::vector<uint32_t>> fixed(thresholds.size());
+
+        std::vector<bool> sweeps[2];
+        bool verdicts[2];
+        for (int run = 0; run < 2; run++) {
+            SmcOptions options;
+            options.num_threads = run == 0 ? 1 : 4;
+            Solver solver;
+            solver.set_seed(i);
+            formula.add_to(solver);
+            sweeps[run] = solver.solve_smc_sweep(thresholds, counting, options);
+            verdicts[run] = solver.solve_smc(thresholds, counting, fixed, options);
+        }
+        CHECK(sweeps[0] == sweeps[1]);
+        CHECK_EQ(verdicts[0], verdicts[1]);
+    }
+}
+
+TEST(hash_families_have_their_shape) {
+    std::mt19937_64 rng(17);
+    std::vector<uint32_t> vars;
+    for (uint32_t var = 0; var < 64; var++) {
+        vars.push_back(3 * var + 1);
+    }
+    const uint32_t num_rows = 20;
+    const int draws = 200;
+    for (HashFamily family : {HashFamily::Dense, HashFamily::Sparse, HashFamily::Toeplitz}) {
+        double row_length = 0;
+        int odd_rhs = 0;
+        for (int draw = 0; draw < draws; draw++) {
+            std::vector<XorConstraint> rows = draw_hash(family, vars, num_rows, -1.0, rng);
+            REQUIRE(rows.size() == num_rows);
+            std::vector<std::vector<uint8_t>> matrix(num_rows, std::vector<uint8_t>(vars.size()));
+            for (uint32_t i = 0; i < num_rows; i++) {
+                CHECK(std::is_sorted(rows[i].vars.begin(), rows[i].vars.end()));
+                for (uint32_t var : rows[i].vars) {
+                    auto it = std::find(vars.begin(), vars.end(), var);
+                    REQUIRE(it != vars.end());
+                    matrix[i][it - vars.begin()] = 1;
+                }
+                row_length += rows[i].vars.size();
+                odd_rhs += rows[i].rhs;
+            }
+            if (family == HashFamily::Toeplitz) {
+                for (uint32_t i = 0; i + 1 < num_rows; i++) {
+                    for (size_t j = 0; j + 1 < vars.size(); j++) {
+                        CHECK_EQ(matrix[i][j], matrix[i + 1][j + 1]);
+                    }
+                }
+            }
+        }
+
+        // Means over 4000 rows, far from their bounds
+        row_length /= draws * num_rows;
+        double expected = family == HashFamily::Sparse ? sparse_density(vars.size(), num_rows) * vars.size()
+                                                       : vars.size() / 2.0;
+        CHECK(std::abs(row_length - expected) < 0.1 * expected);
+        CHECK(std::abs(odd_rhs - draws * num_rows / 2.0) < 0.05 * draws * num_rows);
+    }
+    CHECK(draw_hash(HashFamily::Dense, vars, 0, -1.0, rng).empty());
+}
+
+TEST(vote_budget_and_margin) {
+    SmcOptions options;
+    // ln(100) / (2 * 0.25^2) = 36.8 trials; ln(99) / ln(3) = 4.2 lead
+    CHECK_EQ(smc_trial_budget(options), 37);
+    CHECK_EQ(smc_vote_margin(options), 5);
+
+    options.num_xor_tries = 51;
+    CHECK_EQ(smc_trial_budget(options), 51);
+    options.num_xor_tries = 10;
+    options.confidence = 0.95;
+    CHECK_EQ(smc_trial_budget(options), 25);
+    CHECK_EQ(smc_vote_margin(options), 3);
+
+    // Outside (0.5, 1): num_xor_tries made odd, no sequential test
+    for (double confidence : {0.5, 1.0, 0.0}) {
+        options.confidence = confidence;
+        CHECK_EQ(smc_trial_budget(options), 11);
+        CHECK_EQ(smc_vote_margin(options), std::numeric_limits<int>::max());
+    }
+    options.confidence = 0.99;
+    options.bias = 0.5;
+    CHECK_EQ(smc_vote_margin(options), std::numeric_limits<int>::max());
+}
+
+// With no constraints every trial of threshold 2 is SAT and every trial of
+// 2^20 over 12 variables almost surely UNSAT: the sequential test stops
+// each vote at the margin, or at the majority with the test off
+TEST(clear_votes_are_decided_before_the_budget) {
+    SmallFormula formula;
+    formula.num_vars = 12;
+    std::vector<uint32_t> projection;
+    for (uint32_t var = 0; var < formula.num_vars; var++) {
+        projection.push_back(var);
+    }
+    for (double confidence : {0.99, 1.0}) {
+        SmcOptions options;
+        options.confidence = confidence;
+        const int budget = smc_trial_budget(options);
+        const int expected = confidence < 1.0 ? smc_vote_margin(options) : budget / 2 + 1;
+        for (uint32_t threshold : {2u, 1u << 20}) {
+            Solver solver;
+            solver.set_seed(threshold);
+            formula.add_to(solver);
+            bool verdict = solver.solve_smc({threshold}, {projection}, {{}}, options);
+            CHECK_EQ(verdict, threshold == 2);
+
+            const SmcThresholdStats& stats = solver.smc_stats().thresholds[0];
+            CHECK(stats.decided);
+            CHECK_EQ(stats.successes + stats.failures, expected);
+            CHECK_EQ(int(stats.trials.size()), expected);
+            CHECK(expected < budget);
+        }
+    }
+}
+
+TEST(thread_pool_runs_every_task_once) {
+    for (unsigned num_threads : {1u, 4u}) {
+        ThreadPool pool(num_threads);
+        std::vector<std::atomic<int>> runs(1000);
+        std::atomic<bool> bad_worker{false};
+        for (size_t i = 0; i < runs.size(); i++) {
+            pool.submit([&, i](unsigned worker) {
+                runs[i]++;
+                bad_worker = bad_worker || worker >= num_threads;
+            });
+        }
+        pool.wait();
+        for (const auto& count : runs) {
+            CHECK_EQ(count.load(), 1);
+        }
+        CHECK(!bad_worker);
+    }
+
+    // One worker runs its tasks in submission order
+    ThreadPool pool(1);
+    std::vector<int> order;
+    for (int i = 0; i < 100; i++) {
+        pool.submit([&order, i](unsigned) { order.push_back(i); });
+    }
+    pool.wait();
+    CHECK(std::is_sorted(order.begin(), order.end()));
+    CHECK_EQ(order.size(), 100u);
+}
+
+// Trials are counted in order, so a vote on a clear-cut threshold is only
+// decided early with threads if the workers start the first trials first
+TEST(threaded_votes_stop_before_the_budget) {
+    SmallFormula formula;
+    formula.num_vars = 12;
+    std::vector<uint32_t> projection;
+    for (uint32_t var = 0; var < formula.num_vars; var++) {
+        projection.push_back(var);
+    }
+    for (uint32_t threshold : {2u, 1u << 20}) {
+        SmcOptions options;
+        options.num_threads = 4;
+        options.num_xor_tries = 201;
+        Solver solver;
+        solver.set_seed(threshold);
+        formula.add_to(solver);
+        bool verdict = solver.solve_smc({threshold}, {projection}, {{}}, options);
+        CHECK_EQ(verdict, threshold == 2);
+
+        const SmcThresholdStats& stats = solver.smc_stats().thresholds[0];
+        CHECK(stats.decided);
+        CHECK(stats.successes + stats.failures < 20);
+        CHECK(stats.trials.size() < size_t(options.num_xor_tries));
+    }
+}
+
+TEST(joint_smc_witness_meets_the_threshold) {
+    std::mt19937_64 rng(14);
+    int cases = 0;
+    int wrong = 0;
+    for (int i = 0; i < 60; i++) {
+        SmallFormula formula = random_formula(rng, 10);
+        if (formula.num_vars < 4) {
+            continue;
+        }
+        // The first two variables are fixed, the rest counted
+        std::vector<uint32_t> fixed{0, 1};
+        std::vector<uint32_t> counting;
+        for (uint32_t var = 2; var < formula.num_vars; var++) {
+            counting.push_back(var);
+        }
+        auto count_under = [&](uint32_t assignment) {
+            SmallFormula restricted = formula;
+            for (uint32_t var : fixed) {
+                restricted.clauses.push_back({Literal(var, (assignment >> var) & 1)});
+            }
+            return restricted.count_projected(counting);
+        };
+        uint64_t best = 0;
+        for (uint32_t assignment = 0; assignment < 4; assignment++) {
+            best = std::max(best, count_under(assignment));
+        }
+
+        uint32_t q = rng() % (counting.size() + 1);
+        int expected = expected_verdict(best, q);
+        Solver solver;
+        solver.set_seed(i);
+        formula.add_to(solver);
+        bool verdict = solver.solve_smc({1u << q}, {counting}, {fixed}, SmcOptions());
+        if (expected >= 0) {
+            cases++;
+            wrong += verdict != bool(expected);
+        }
+        if (verdict) {
+            const auto& witness = solver.smc_witness();
+            REQUIRE(witness.size() == fixed.size());
+            uint32_t assignment = 0;
+            for (const Literal& lit : witness) {
+                assignment |= uint32_t(lit.is_positive()) << lit.var_id();
+            }
+            // Far below the threshold would be a wrong witness
+            if (expected_verdict(count_under(assignment), q) == 0) {
+                wrong++;
+            }
+        }
+    }
+    CHECK(cases > 20);
+    CHECK(wrong * 20 <= cases);
+}
+
+TEST(count_is_within_tolerance) {
+    std::mt19937_64 rng(15);
+    int cases = 0;
+    int within = 0;
+    for (int i = 0; i < 100; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+        std::vector<uint32_t> projection = random_projection(rng, formula.num_vars);
+        uint64_t exact = formula.count_projected(projection);
+
+        Solver solver;
+        solver.set_seed(i);
+        formula.add_to(solver);
+        CountOptions options;
+        CountResult result = solver.count(projection, options);
+        if (exact == 0) {
+            CHECK_EQ(result.estimate(), 0.0);
+            continue;
+        }
+        double ratio = result.estimate() / exact;
+        cases++;
+        within += ratio <= 1 + options.epsilon && ratio >= 1 / (1 + options.epsilon);
+        if (result.exact) {
+            CHECK_EQ(result.estimate(), static_cast<double>(exact));
+        }
+    }
+    // The guarantee is only 1 - delta per count, but small counts come
+    // out far better, most of them exact
+    CHECK(within >= 0.9 * cases);
+}
+
+TEST(count_with_each_hash_family) {
+    std::mt19937_64 rng(16);
+    for (HashFamily family : {HashFamily::Sparse, HashFamily::Toeplitz}) {
+        int cases = 0;
+        int within = 0;
+        for (int i = 0; i < 40; i++) {
+            SmallFormula formula = random_formula(rng, 14);
+            std::vector<uint32_t> projection = random_projection(rng, formula.num_vars);
+            uint64_t exact = formula.count_projected(projection);
+
+            Solver solver;
+            solver.set_seed(i);
+            formula.add_to(solver);
+            CountOptions options;
+            options.hash = family;
+            double ratio = solver.count(projection, options).estimate() / std::max<uint64_t>(exact, 1);
+            cases++;
+            within += exact == 0 ? ratio == 0 : ratio <= 1 + options.epsilon && ratio >= 1 / (1 + options.epsilon);
+        }
+        CHECK(within >= 0.9 * cases);
+    }
+
+    // The prefixes count() tests are never sparser than the full hash
+    for (uint32_t n = 1; n <= 200; n++) {
+        for (uint32_t m = 0; m < n; m++) {
+            CHECK(sparse_density(n, m) <= sparse_density(n, n));
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    return run_tests(argc, argv);
+}
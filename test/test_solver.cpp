@@ -0,0 +1,376 @@
+#include "Check.hpp"
+#include "RandomFormula.hpp"
+#include "xor_smc/Dimacs.hpp"
+#include "xor_smc/Restart.hpp"
+#include "xor_smc/Solver.hpp"
+#include <algorithm>
+#include <random>
+
+using namespace xor_smc;
+using namespace xor_smc::test;
+
+namespace {
+
+// Solves and checks the answer against enumeration, and any model against
+// the formula; an UNSAT answer leaves no model behind
+void check_solve(Solver& solver, const SmallFormula& formula) {
+    bool sat = solver.solve();
+    CHECK_EQ(sat, formula.count_models() > 0);
+    if (sat) {
+        CHECK(formula.satisfied(solver.get_model()));
+    } else {
+        CHECK(solver.get_model().empty());
+    }
+}
+
+}
+
+TEST(solve_matches_enumeration) {
+    std::mt19937_64 rng(1);
+    for (int i = 0; i < 3000; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+        Solver solver;
+        solver.set_seed(i);
+        formula.add_to(solver);
+        check_solve(solver, formula);
+    }
+}
+
+TEST(cnf_xor_encoding_matches_enumeration) {
+    std::mt19937_64 rng(2);
+    for (int i = 0; i < 2000; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+        Solver solver;
+        solver.set_native_xor(false);
+        solver.set_xor_chunk_width(3 + i % 3);
+        formula.add_to(solver);
+        check_solve(solver, formula);
+    }
+}
+
+// Many overlapping XORs and few clauses keep the XOR engine pivoting and
+// backtracking; assumptions make each solve start from a different trail
+TEST(xor_systems_match_enumeration) {
+    std::mt19937_64 rng(9);
+    for (int i = 0; i < 1000; i++) {
+        SmallFormula formula;
+        formula.num_vars = 4 + rng() % 11;
+        uint32_t num_xors = 2 + rng() % 8;
+        for (uint32_t j = 0; j < num_xors; j++) {
+            std::vector<Literal> xor_lits;
+            for (uint32_t var = 0; var < formula.num_vars; var++) {
+                if (rng() % 3 == 0) {
+                    xor_lits.push_back(Literal(var, rng() & 1));
+                }
+            }
+            if (!xor_lits.empty()) {
+                formula.xors.push_back(xor_lits);
+            }
+        }
+        for (uint32_t j = rng() % formula.num_vars; j > 0; j--) {
+            formula.clauses.push_back({random_literal(rng, formula.num_vars), random_literal(rng, formula.num_vars),
+                                       random_literal(rng, formula.num_vars)});
+        }
+
+        Solver solver;
+        solver.set_seed(i);
+        formula.add_to(solver);
+        for (int round = 0; round < 4; round++) {
+            std::vector<Literal> assumptions;
+            for (uint32_t j = rng() % 4; j > 0; j--) {
+                assumptions.push_back(random_literal(rng, formula.num_vars));
+            }
+            bool sat = solver.solve(assumptions);
+            CHECK_EQ(sat, formula.count_models(assumptions) > 0);
+            if (sat) {
+                CHECK(formula.satisfied(solver.get_model()));
+            }
+        }
+    }
+}
+
+// Units and binaries stay out of the adopted clause array, so the arena
+// holds exactly the long clauses and nothing is freed or compacted
+TEST(adopted_formula_keeps_only_long_clauses) {
+    std::mt19937_64 rng(10);
+    Formula formula;
+    formula.set_num_variables(500);
+    for (int i = 0; i < 5000; i++) {
+        formula.add_clause({Literal(rng() % 250, true), Literal(250 + rng() % 250, true)});
+    }
+    for (uint32_t var = 0; var < 300; var += 3) {
+        formula.add_clause({Literal(var, true), Literal(var + 1, false), Literal(var + 2, true)});
+    }
+    formula.add_clause({Literal(499, true)});
+    CHECK_EQ(formula.num_clauses(), 5101u);
+    CHECK_EQ(formula.clause(0).size(), 1u);
+    CHECK_EQ(formula.clause(1).size(), 2u);
+    CHECK_EQ(formula.clause(5100).size(), 3u);
+
+    Solver solver(std::move(formula));
+#ifndef XOR_SMC_NO_STATS
+    CHECK_EQ(solver.stats().peak_clause_bytes, 100 * (2 + 3) * sizeof(uint32_t));
+#endif
+    CHECK(solver.solve());
+}
+
+TEST(formula_and_bulk_paths_match_enumeration) {
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 1000; i++) {
+        SmallFormula formula = random_formula(rng, 14);
+
+        Solver adopted(formula.to_formula());
+        check_solve(adopted, formula);
+
+        Solver bulk;
+        bulk.set_num_variables(formula.num_vars);
+        std::vector<Literal> literals;
+        std::vector<size_t> offsets{0};
+        for (const auto& clause : formula.clauses) {
+            literals.insert(literals.end(), clause.begin(), clause.end());
+            offsets.push_back(literals.size());
+        }
+        bulk.add_clauses(literals.data(), offsets.data(), formula.clauses.size());
+        for (const auto& xor_lits : formula.xors) {
+            bulk.add_xor(xor_lits);
+        }
+        check_solve(bulk, formula);
+
+        // A formula added to a solver that already has part of it
+        Solver merged;
+        SmallFormula first_half = formula;
+        first_half.clauses.resize(formula.clauses.size() / 2);
+        first_half.xors.clear();
+        first_half.add_to(merged);
+        merged.solve();
+        merged.add_formula(formula.to_formula());
+        check_solve(merged, formula);
+    }
+}
+
+TEST(unsat_solve_drops_the_previous_model) {
+    Solver solver;
+    solver.set_num_variables(2);
+    solver.add_clause({Literal(0, true), Literal(1, true)});
+    CHECK(solver.solve());
+    CHECK_EQ(solver.get_model().size(), 2u);
+
+    // UNSAT under assumptions, then for good
+    CHECK(!solver.solve({Literal(0, false), Literal(1, false)}));
+    CHECK(solver.get_model().empty());
+    CHECK(solver.solve({Literal(0, false)}));
+    CHECK(solver.get_value(1));
+    solver.add_clause({Literal(0, false)});
+    solver.add_clause({Literal(1, false)});
+    CHECK(!solver.solve());
+    CHECK(solver.get_model().empty());
+}
+
+TEST(incremental_clauses_match_enumeration) {
+    std::mt19937_64 rng(4);
+    for (int i = 0; i < 500; i++) {
+        SmallFormula full = random_formula(rng, 12);
+        SmallFormula added;
+        added.num_vars = full.num_vars;
+        added.xors = full.xors;
+
+        Solver solver;
+        added.add_to(solver);
+        check_solve(solver, added);
+        for (const auto& clause : full.clauses) {
+            solver.add_clause(clause);
+            added.clauses.push_back(clause);
+            if (rng() % 4 == 0) {
+                check_solve(solver, added);
+            }
+        }
+        check_solve(solver, added);
+    }
+}
+
+TEST(assumptions_match_enumeration) {
+    std::mt19937_64 rng(5);
+    for (int i = 0; i < 1000; i++) {
+        SmallFormula formula = random_formula(rng, 12);
+        Solver solver;
+        formula.add_to(solver);
+        for (int round = 0; round < 5; round++) {
+            std::vector<Literal> assumptions(rng() % 4);
+            for (Literal& lit : assumptions) {
+                lit = random_literal(rng, formula.num_vars);
+            }
+            bool sat = solver.solve(assumptions);
+            CHECK_EQ(sat, formula.count_models(assumptions) > 0);
+            if (sat) {
+                CHECK(formula.satisfied(solver.get_model()));
+                for (const Literal& lit : assumptions) {
+                    CHECK_EQ(solver.get_value(lit.var_id()), lit.is_positive());
+                }
+            } else {
+                // A subset of the assumptions that is inconsistent by itself
+                const auto& failed = solver.failed_assumptions();
+                for (const Literal& lit : failed) {
+                    CHECK(std::find(assumptions.begin(), assumptions.end(), lit) != assumptions.end());
+                }
+                CHECK_EQ(formula.count_models(failed), 0u);
+            }
+        }
+    }
+}
+
+TEST(groups_retract_their_constraints) {
+    std::mt19937_64 rng(6);
+    for (int i = 0; i < 500; i++) {
+        SmallFormula base = random_formula(rng, 12);
+        SmallFormula extra = random_formula(rng, base.num_vars);
+        SmallFormula both = base;
+        both.clauses.insert(both.clauses.end(), extra.clauses.begin(), extra.clauses.end());
+        both.xors.insert(both.xors.end(), extra.xors.begin(), extra.xors.end());
+
+        Solver solver;
+        base.add_to(solver);
+        uint32_t group = solver.new_group();
+        for (const auto& clause : extra.clauses) {
+            solver.add_clause(clause, group);
+        }
+        for (const auto& xor_lits : extra.xors) {
+            solver.add_xor(xor_lits, group);
+        }
+        check_solve(solver, both);
+        solver.set_group_enabled(group, false);
+        check_solve(solver, base);
+        solver.set_group_enabled(group, true);
+        check_solve(solver, both);
+        solver.release_group(group);
+        check_solve(solver, base);
+    }
+}
+
+TEST(blocking_clauses_enumerate_every_model) {
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 300; i++) {
+        SmallFormula formula = random_formula(rng, 8);
+        Solver solver;
+        formula.add_to(solver);
+        uint64_t found = 0;
+        while (solver.solve() && found <= formula.count_models()) {
+            CHECK(formula.satisfied(solver.get_model()));
+            solver.add_blocking_clause(solver.get_model());
+            found++;
+        }
+        CHECK_EQ(found, formula.count_models());
+    }
+}
+
+// Long searches, where conflict analysis, clause database reduction and
+// restarts all run; with assertions on, every learnt clause is checked to
+// be ordered as backjumping expects
+TEST(hard_instances_give_valid_answers) {
+    std::mt19937_64 rng(8);
+    for (int i = 0; i < 20; i++) {
+        const uint32_t num_vars = 120;
+        Solver solver;
+        solver.set_seed(i);
+        solver.set_num_variables(num_vars);
+        std::vector<std::vector<Literal>> clauses;
+        for (uint32_t j = 0; j < 426 * num_vars / 100; j++) {
+            std::vector<Literal> clause(3);
+            for (Literal& lit : clause) {
+                lit = random_literal(rng, num_vars);
+            }
+            solver.add_clause(clause);
+            clauses.push_back(clause);
+        }
+        if (solver.solve()) {
+            auto model = solver.get_model();
+            for (const auto& clause : clauses) {
+                CHECK(std::any_of(clause.begin(), clause.end(),
+                                  [&](const Literal& lit) { return model[lit.var_id()] == lit.is_positive(); }));
+            }
+        }
+    }
+
+    // Seven pigeons in six holes
+    Solver pigeons;
+    pigeons.set_num_variables(7 * 6);
+    auto var = [](uint32_t p, uint32_t h) { return p * 6 + h; };
+    for (uint32_t p = 0; p < 7; p++) {
+        std::vector<Literal> clause;
+        for (uint32_t h = 0; h < 6; h++) {
+            clause.push_back(Literal(var(p, h), true));
+        }
+        pigeons.add_clause(clause);
+    }
+    for (uint32_t h = 0; h < 6; h++) {
+        for (uint32_t p = 0; p < 7; p++) {
+            for (uint32_t q = p + 1; q < 7; q++) {
+                pigeons.add_clause({Literal(var(p, h), false), Literal(var(q, h), false)});
+            }
+        }
+    }
+    CHECK(!pigeons.solve());
+}
+
+TEST(restart_policies_follow_their_schedules) {
+    const double expected[] = {1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, 1};
+    for (uint64_t i = 0; i < 16; i++) {
+        CHECK_EQ(LubyRestart::luby(2, i), expected[i]);
+    }
+
+    // unit * luby(i) conflicts before restart i
+    LubyRestart luby(10);
+    for (int restart = 0; restart < 16; restart++) {
+        for (int conflict = 0; conflict < 10 * expected[restart]; conflict++) {
+            CHECK(!luby.should_restart());
+            luby.on_conflict(3, 100);
+        }
+        CHECK(luby.should_restart());
+        luby.on_restart();
+    }
+
+    // Steady LBDs never restart; a run of much worse ones does, once
+    // enough conflicts have passed since the last restart
+    GlucoseRestart glucose;
+    for (int conflict = 0; conflict < 1000; conflict++) {
+        glucose.on_conflict(2, 100);
+        CHECK(!glucose.should_restart());
+    }
+    for (int conflict = 0; conflict < 50; conflict++) {
+        glucose.on_conflict(20, 100);
+    }
+    CHECK(glucose.should_restart());
+    glucose.on_restart();
+    CHECK(!glucose.should_restart());
+    for (int conflict = 0; conflict < 49; conflict++) {
+        glucose.on_conflict(20, 100);
+    }
+    CHECK(!glucose.should_restart());
+    glucose.on_conflict(20, 100);
+    CHECK(glucose.should_restart());
+}
+
+TEST(dimacs_round_trip) {
+    std::mt19937_64 rng(9);
+    for (int i = 0; i < 300; i++) {
+        SmallFormula formula = random_formula(rng, 12);
+        std::string text = "c random formula\n" + formula.to_dimacs();
+
+        Formula parsed;
+        DimacsInfo info;
+        REQUIRE(parse_dimacs(text.data(), text.size(), parsed, info));
+        CHECK_EQ(info.clauses_read, formula.clauses.size());
+        CHECK_EQ(info.xors_read, formula.xors.size());
+        Solver solver(std::move(parsed));
+        check_solve(solver, formula);
+    }
+
+    Solver solver;
+    DimacsInfo info;
+    const std::string bad = "p cnf 2 1\n1 x 0\n";
+    CHECK(!parse_dimacs(bad.data(), bad.size(), solver, info));
+    CHECK(!info.error.empty());
+}
+
+int main(int argc, char** argv) {
+    return run_tests(argc, argv);
+}